@@ -1,13 +1,18 @@
 #pragma once
 
 #include <random>
+#include <span>
+#include <unordered_map>
 #include <vector>
 #include <ranges>
 #include <functional>
 #include <cmath>
 #include <algorithm>
-#include <iostream>
-#include <format>
+#include <array>
+#include <cstdint>
+#include <expected>
+
+#include "async_logger.hpp"
 
 namespace exchange
 {
@@ -36,8 +41,8 @@ public:
                  std::size_t order_size): 
         m_placement_distribution({order_placement_rate}),
         m_cancellation_distribution({order_cancellation_rate}),
-        m_order_size(order_size),
-        m_buy_side_distribution(0, 1)
+        m_buy_side_distribution(0, 1),
+        m_order_size(order_size)
     {
         auto rd = std::random_device{};
         auto seed_data = std::array<SeedType, RandomGeneratorType::state_size>{};
@@ -46,8 +51,74 @@ public:
         m_eng = RandomGeneratorType{seed};
     }
 
+    // Draws from a fixed seed, so that runs can be reproduced.
+    PatientAgent(double order_placement_rate,
+                 double order_cancellation_rate,
+                 std::size_t order_size,
+                 uint64_t seed):
+        m_placement_distribution({order_placement_rate}),
+        m_cancellation_distribution({order_cancellation_rate}),
+        m_buy_side_distribution(0, 1),
+        m_order_size(order_size)
+    {
+        auto seed_seq = std::seed_seq{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+        m_eng = RandomGeneratorType{seed_seq};
+    }
+
     auto act();
 
+    enum class Action
+    {
+        PLACE,
+        CANCEL
+    };
+
+    struct NextAction
+    {
+        double delay;
+        Action action;
+    };
+
+    // For event driven simulation, where the agent acts one order at a time
+    // rather than once per timestep. The time until it next acts is
+    // exponential at its placement and cancellation rates combined, and the
+    // action is a placement in proportion to the placement rate.
+    auto draw_next_action() -> NextAction
+    {
+        auto placement_rate = m_placement_distribution.mean();
+        auto rate = placement_rate + m_cancellation_distribution.mean();
+        auto delay = std::exponential_distribution<double>{rate}(m_eng);
+        auto place = std::bernoulli_distribution{placement_rate / rate}(m_eng);
+
+        return {delay, place ? Action::PLACE : Action::CANCEL};
+    }
+
+    // Returns false if a placement failed.
+    auto perform(Action action) -> bool
+    {
+        if (action == Action::PLACE)
+            return place_order();
+
+        if (!m_active_orders.empty())
+            cancel_order();
+
+        return true;
+    }
+
+    // Tells the agent some of one of its resting orders traded, leaving
+    // remaining. Once nothing remains it is no longer a cancel candidate.
+    auto on_execution(OrderIDType order_id, std::size_t remaining) -> void
+    {
+        if (!remaining)
+            remove_active_order(order_id);
+    }
+
+    // Orders the agent believes are resting, in no particular order.
+    auto active_orders() const -> std::span<const OrderIDType>
+    {
+        return m_active_orders;
+    }
+
     auto post_place_callback(PlaceOrderCallbackType place_callback)
     {
         m_place_callback = place_callback;
@@ -68,7 +139,10 @@ private:
     std::uniform_int_distribution<unsigned> m_buy_side_distribution;
     unsigned m_order_size;
 
+    // Live orders, with each one's position so that removal is a swap with
+    // the last and a pop.
     std::vector<OrderIDType> m_active_orders;
+    std::unordered_map<OrderIDType, std::size_t> m_active_slots;
     std::function<bool(OrderIDType)> m_cancel_callback;
     PlaceOrderCallbackType m_place_callback;
 
@@ -80,20 +154,7 @@ private:
             orders_to_cancel = m_active_orders.size();
 
         for (auto _: std::views::iota(0u, orders_to_cancel))
-        {
-            auto index_dist =
-                 std::uniform_int_distribution<unsigned long>{0, m_active_orders.size()};
-
-            auto index_to_cancel = index_dist(m_eng);
-            auto success = m_cancel_callback(m_active_orders[index_to_cancel]);
-
-            if (success)
-                m_active_orders.erase(m_active_orders.begin() + index_to_cancel);
-            else
-                // TODO: If not successful, was the order already filled?
-                // For now, remove it all the same.
-                m_active_orders.erase(m_active_orders.begin() + index_to_cancel);
-        }
+            cancel_order();
     }
 
     auto try_place_order() -> bool
@@ -101,26 +162,71 @@ private:
         auto orders_to_place = m_placement_distribution(m_eng);
 
         for (auto _: std::views::iota(0u, orders_to_place))
-        {
-            auto current_best = 45.0;
-            auto price_dist = std::uniform_real_distribution<double>(0, std::log(current_best));
-            auto price = std::exp(price_dist(m_eng));
-            auto side = static_cast<Side>(m_buy_side_distribution(m_eng));
-
-            if (auto ret = m_place_callback(side, m_order_size, price))
-            {
-                m_active_orders.push_back(ret.value());
-            }
-            else if (ret.error() == PlaceOutcome::FILLED_IMMEDIATELY)
-            {
-                // Don't add to the active order list, possibly use this
-                // to tracl P/L metrics.
-            }
-            else
-            {
-                std::cout << std::format("Placement failed.");
+            if (!place_order())
                 return false;
-            }
+
+        return true;
+    }
+
+    // Cancels one active order picked at random, there must be one.
+    auto cancel_order() -> void
+    {
+        auto index_dist =
+             std::uniform_int_distribution<unsigned long>{0, m_active_orders.size() - 1};
+
+        auto order_id = m_active_orders[index_dist(m_eng)];
+
+        // Fills are reported as they happen, so a failed cancel means the
+        // order traded before its report arrived. Either way it is gone.
+        m_cancel_callback(order_id);
+        remove_active_order(order_id);
+    }
+
+    auto add_active_order(OrderIDType order_id) -> void
+    {
+        m_active_slots.insert_or_assign(order_id, m_active_orders.size());
+        m_active_orders.push_back(order_id);
+    }
+
+    auto remove_active_order(OrderIDType order_id) -> void
+    {
+        auto it = m_active_slots.find(order_id);
+
+        if (it == m_active_slots.end())
+            return;
+
+        auto slot = it->second;
+        m_active_slots.erase(it);
+
+        if (slot != m_active_orders.size() - 1)
+        {
+            m_active_orders[slot] = m_active_orders.back();
+            m_active_slots[m_active_orders[slot]] = slot;
+        }
+
+        m_active_orders.pop_back();
+    }
+
+    auto place_order() -> bool
+    {
+        auto current_best = 45.0;
+        auto price_dist = std::uniform_real_distribution<double>(0, std::log(current_best));
+        auto price = std::exp(price_dist(m_eng));
+        auto side = static_cast<Side>(m_buy_side_distribution(m_eng));
+
+        if (auto ret = m_place_callback(side, m_order_size, price))
+        {
+            add_active_order(ret.value());
+        }
+        else if (ret.error() == PlaceOutcome::FILLED_IMMEDIATELY)
+        {
+            // Don't add to the active order list, possibly use this
+            // to tracl P/L metrics.
+        }
+        else
+        {
+            log_warn<"Placement failed.">();
+            return false;
         }
 
         return true;
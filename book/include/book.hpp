@@ -2,43 +2,68 @@
 
 #include <cstdint>
 #include <functional>
-#include <queue>
-#include <set>
-#include <map>
+#include <algorithm>
 #include <format>
 #include <iostream>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <vector>
+
+#include "order.hpp"
+#include "price_level.hpp"
+#include "price_levels.hpp"
+#include "order_pool.hpp"
+#include "order_id.hpp"
+#include "order_index.hpp"
+#include "fill_event.hpp"
+#include "book_snapshot.hpp"
+#include "clearing_price.hpp"
 
-#include <uuid/uuid.h>
-
-using order_id = uint32_t;
-using order_size = uint32_t;
-using order_price = uint32_t;
 using order_complete_cb = std::function<int(order_id, order_size, order_price)>;
+using fill_batch_cb = std::function<void(std::span<const fill_event>)>;
 
-enum class order_type
+// How incoming limit orders meet the book. In a call auction they rest
+// without matching, leaving the book crossed, until uncross() trades
+// everything that can trade at a single price.
+enum class matching_mode
 {
-    LIM_BUY,
-    LIM_SELL,
-    FOK_BUY,
-    FOK_SELL
+    CONTINUOUS,
+    CALL_AUCTION
 };
 
-struct order
-{
-    order_id id;
-    order_size size;
-    order_price price;
-    order_type type;
-};
-
-inline auto better_buy = [](order* lhs, order* rhs){ return lhs->price > rhs->price; };
-inline auto better_sell = [](order* lhs, order* rhs){ return lhs->price < rhs->price; };
-
-class Book
+// Listener is called inline from the matching loop for every fill (see
+// no_fill_listener), so a concrete policy type costs no indirect call.
+template <typename Backend, typename Listener = no_fill_listener>
+class BasicBook
 {
 public:
     using OrderIDType = order_id;
 
+    // Returned by limit orders that filled on arrival, leaving nothing to
+    // rest.
+    static constexpr OrderIDType FILLED = static_cast<OrderIDType>(-1);
+
+    // Returned by limit orders priced outside what the backend can hold. No
+    // book hands out id 0.
+    static constexpr OrderIDType REJECTED = 0;
+
+    BasicBook()
+    {
+        m_fills.reserve(DEFAULT_FILL_CAPACITY);
+    }
+
+    // Preallocates room for order_capacity resting orders. Ids handed out
+    // by this book carry id_prefix in their top bits.
+    explicit BasicBook(std::size_t order_capacity, uint16_t id_prefix = 0):
+        m_pool(order_capacity),
+        m_ids(id_prefix),
+        order_list(order_capacity)
+    {
+        m_fills.reserve(DEFAULT_FILL_CAPACITY);
+    }
+
     auto limit_buy(order_size, order_price) -> OrderIDType;
 
     auto limit_sell(order_size, order_price) -> OrderIDType;
@@ -49,14 +74,108 @@ public:
 
     auto cancel_order(OrderIDType id) -> bool;
 
+    // Volume a buy or sell limited to price could trade against the book
+    // right now, summed from the aggregate volume of each crossing level.
+    auto executable_buy(order_price) -> level_volume;
+
+    auto executable_sell(order_price) -> level_volume;
+
+    // Switching back to continuous matching uncrosses the book first.
+    auto set_matching_mode(matching_mode) -> void;
+
+    auto mode() const -> matching_mode
+    {
+        return m_mode;
+    }
+
+    // Trades every crossing order at the price that executes the most volume
+    // (see find_clearing_price()), priority going to better prices then to
+    // time. Each order that trades gets one fill for all it traded, so the
+    // fills of either side add up to the volume of the auction. FOK orders
+    // are refused while in a call auction, as nothing trades on arrival.
+    auto uncross() -> auction_result;
+
     auto post_order_complete_callback(order_complete_cb) -> void;
 
+    // Called once per matching order with all of the fills it produced.
+    auto post_fill_batch_callback(fill_batch_cb) -> void;
+
+    // Writes every resting order and the id generator state (see
+    // book_snapshot.hpp). Returns false if the stream failed.
+    auto save(std::ostream&) -> bool;
+
+    // Rebuilds an empty book from a snapshot written by save(), in time
+    // proportional to the orders in it. Returns false, leaving the book
+    // empty, if the book was not or the snapshot is malformed.
+    auto restore(std::istream&) -> bool;
+
+    // Fills produced by the most recent limit or FOK order.
+    auto fills() const -> std::span<const fill_event>
+    {
+        return m_fills;
+    }
+
+    auto listener() -> Listener&
+    {
+        return m_listener;
+    }
+
+    auto order_pool_stats() const -> order_pool::stats
+    {
+        return m_pool.get_stats();
+    }
+
+    // Best resting prices, empty while that side of the book is.
+    auto best_bid() -> std::optional<order_price>
+    {
+        if (auto level = buy_book.best())
+            return level->price;
+
+        return std::nullopt;
+    }
+
+    auto best_ask() -> std::optional<order_price>
+    {
+        if (auto level = sell_book.best())
+            return level->price;
+
+        return std::nullopt;
+    }
+
+    // Total volume resting on each side.
+    auto bid_depth() const -> level_volume
+    {
+        return buy_book.depth;
+    }
+
+    auto ask_depth() const -> level_volume
+    {
+        return sell_book.depth;
+    }
+
 private:
+    static constexpr std::size_t DEFAULT_FILL_CAPACITY = 256;
+    static constexpr std::size_t SNAPSHOT_READ_CHUNK = 4096;
 
     order_complete_cb _cb;
-    std::set<order*, decltype(better_buy)> buy_book;
-    std::set<order*, decltype(better_sell)> sell_book; // Take advantage of RB tree used to order set.
-    std::map<OrderIDType, order*> order_list;
+    fill_batch_cb m_batch_cb;
+    [[no_unique_address]] Listener m_listener;
+    std::vector<fill_event> m_fills;
+    order_pool m_pool;
+    // One entry per price level. Orders at a level queue intrusively, and
+    // both backends find an existing level in O(1), so only the first order
+    // at a new price pays for ordering the levels.
+    typename Backend::template levels<book_side::BUY> buy_book;
+    typename Backend::template levels<book_side::SELL> sell_book;
+    order_id_generator m_ids;
+    order_index order_list;
+    matching_mode m_mode = matching_mode::CONTINUOUS;
+    // Aggregate depth at the candidate prices of an uncross, kept between
+    // auctions so they do not allocate.
+    std::vector<order_price> m_auction_prices;
+    std::vector<level_volume> m_auction_bids;
+    std::vector<level_volume> m_auction_asks;
+    std::vector<price_level*> m_crossing_bids;
 
     template <order_type OrderType>
     requires (OrderType == order_type::LIM_BUY || OrderType == order_type::FOK_BUY)
@@ -87,30 +206,43 @@ private:
     }
 
     template <order_type OrderType>
-    auto common_add_order(order_size, order_price) -> order_size;
+    auto common_add_order(order_size, order_price) -> OrderIDType;
 
     template <order_type OrderType>
     auto common_fok_order(order_size, order_price) -> bool;
 
     template <order_type OrderType>
-    auto action(order_size, order_price, bool);
+    auto can_fill(order_size, order_price) -> bool;
 
-};
+    template <order_type OrderType>
+    auto executable_volume(order_price, level_volume enough) -> level_volume;
+
+    template <order_type OrderType>
+    auto action(order_size, order_price);
+
+    auto publish_fills() -> void;
+
+    auto collect_crossing_depth() -> void;
+
+    template <order_type OrderType>
+    auto execute_auction(level_volume, order_price) -> void;
+
+    template <book_side Side>
+    auto collect_side() -> std::vector<order_snapshot>;
+
+    template <order_type OrderType>
+    auto restore_side(std::span<const order_snapshot>) -> bool;
+
+    auto clear() -> void;
 
-union uuid_hack
-{
-    uuid_t buf;
-    order_id id;
 };
 
 template <order_type OrderType>
-auto inline build_order(order_size size, order_price price) -> order*
+auto inline build_order(order_pool& pool, order_id id, order_size size, order_price price) -> order*
 {   
-    auto o = new order;
-    uuid_hack id;
-    uuid_generate(id.buf);
+    auto o = pool.acquire();
 
-    o->id = id.id;
+    o->id = id;
     o->size = size;
     o->price = price;
     o->type = OrderType;
@@ -132,127 +264,472 @@ constexpr inline auto get_is_better()
     return [](order_price sell, order_price buy) { return sell <= buy; };
 }
 
+// Sums the aggregate volume of the opposing levels price crosses, without
+// touching individual orders, stopping once there is enough.
+template <typename Backend, typename Listener>
+template <order_type OrderType>
+inline auto BasicBook<Backend, Listener>::executable_volume(order_price price, level_volume enough) -> level_volume
+{
+    auto& opposing_book = get_opposing_order_book<OrderType>();
+    constexpr auto better = get_is_better<OrderType>();
+    auto volume = level_volume{0};
+
+    for (auto level = opposing_book.best();
+         level && volume < enough && better(price, level->price);
+         level = opposing_book.next(level))
+        volume += level->volume;
+
+    return volume;
+}
+
+// Answers whether size could be filled at price or better.
+template <typename Backend, typename Listener>
+template <order_type OrderType>
+inline auto BasicBook<Backend, Listener>::can_fill(order_size size, order_price price) -> bool
+{
+    if (get_opposing_order_book<OrderType>().depth < size)
+        return false;
+
+    return executable_volume<OrderType>(price, size) >= size;
+}
+
+template <typename Backend, typename Listener>
+inline auto BasicBook<Backend, Listener>::executable_buy(order_price price) -> level_volume
+{
+    return executable_volume<order_type::LIM_BUY>(price, sell_book.depth);
+}
+
+template <typename Backend, typename Listener>
+inline auto BasicBook<Backend, Listener>::executable_sell(order_price price) -> level_volume
+{
+    return executable_volume<order_type::LIM_SELL>(price, buy_book.depth);
+}
+
+template <typename Backend, typename Listener>
 template <order_type OrderType>
-inline auto Book::action(order_size size, order_price price, bool dry_run)
+inline auto BasicBook<Backend, Listener>::action(order_size size, order_price price)
 {
     auto& opposing_book = get_opposing_order_book<OrderType>();
     constexpr auto better = get_is_better<OrderType>();
-    bool erase_last = true;
-    auto best = opposing_book.begin();
+    auto level = opposing_book.best();
 
-    while (size)
+    while (size && level && better(price, level->price))
     {
-        if (best == opposing_book.end())
-            break;
+        auto resting = level->head;
 
-        if (better(price, (*best)->price))
+        while (size && resting)
         {
-            if (size >= (*best)->size)
+            auto next = resting->next;
+            auto filled = std::min(size, resting->size);
+            size -= filled;
+            opposing_book.depth -= filled;
+
+            auto& fill = m_fills.emplace_back(resting->id,
+                                              filled,
+                                              resting->price,
+                                              resting->size - filled,
+                                              OrderType,
+                                              price);
+            m_listener.on_fill(fill);
+
+            if (filled == resting->size)
             {
-                size -= (*best)->size;
-
-                if (!dry_run)
-                {
-                    if (_cb)
-                        _cb((*best)->id, (*best)->size, (*best)->price);
-
-                    order_list.erase((*best)->id);
-                    delete *best;
-                }
+                level->erase(resting);
+                order_list.erase(resting->id);
+                m_pool.release(resting);
             }
             else
             {
-                if (!dry_run)
-                {
-                    if (_cb)
-                        _cb((*best)->id, (*best)->size - size, (*best)->price);
-                    
-                    (*best)->size -= size;
-                }
-
-                size = 0;
-                best++;
-                break;
+                resting->size -= filled;
+                level->volume -= filled;
             }
+
+            resting = next;
         }
-        else
-            break;
 
-        best++;
-    }
+        if (level->empty())
+            opposing_book.remove(level);
 
-    if (!dry_run)
-    {
-        opposing_book.erase(opposing_book.begin(), best);
+        level = opposing_book.best();
     }
 
+    publish_fills();
+
     return size;
 }
 
+template <typename Backend, typename Listener>
+inline auto BasicBook<Backend, Listener>::publish_fills() -> void
+{
+    if (m_fills.empty())
+        return;
+
+    if (m_batch_cb)
+        m_batch_cb(m_fills);
+
+    if (_cb)
+        for (auto& fill: m_fills)
+            _cb(fill.resting_id, fill.size, fill.price);
+}
+
+template <typename Backend, typename Listener>
 template <order_type OrderType>
-inline auto Book::common_add_order(order_size size, order_price price) -> OrderIDType
+inline auto BasicBook<Backend, Listener>::common_add_order(order_size size, order_price price) -> OrderIDType
 {
-    auto remaining_size = action<OrderType>(size, price, false);
+    m_fills.clear();
+
+    if (!get_order_book<OrderType>().accepts(price))
+        return REJECTED;
+
+    auto remaining_size = m_mode == matching_mode::CONTINUOUS ? action<OrderType>(size, price) : size;
     
     if (!remaining_size)
-        return -1;
+        return FILLED;
 
     auto& same_book = get_order_book<OrderType>();
-    auto o = build_order<OrderType>(remaining_size, price);
-    same_book.insert(o);
-    order_list[o->id] = o;
+    auto o = build_order<OrderType>(m_pool, m_ids.next(), remaining_size, price);
+    same_book.get_or_insert(price).push_back(o);
+    same_book.depth += remaining_size;
+    order_list.insert(o->id, o);
     return o->id;  
 }
 
+template <typename Backend, typename Listener>
 template <order_type OrderType>
-inline auto Book::common_fok_order(order_size size, order_price price) -> bool
+inline auto BasicBook<Backend, Listener>::common_fok_order(order_size size, order_price price) -> bool
 {
-    auto remaining_size = action<OrderType>(size, price, true);
-    
-    if (remaining_size)
+    m_fills.clear();
+
+    if (!get_order_book<OrderType>().accepts(price))
+        return false;
+
+    if (m_mode == matching_mode::CALL_AUCTION || !can_fill<OrderType>(size, price))
         return false;
 
-    action<OrderType>(size, price, false);
+    action<OrderType>(size, price);
     return true;
 }
 
-inline auto Book::limit_buy(order_size size, order_price price) -> OrderIDType
+template <typename Backend, typename Listener>
+inline auto BasicBook<Backend, Listener>::limit_buy(order_size size, order_price price) -> OrderIDType
 {
     return common_add_order<order_type::LIM_BUY>(size, price);
 }
-inline auto Book::limit_sell(order_size size, order_price price) -> OrderIDType
+template <typename Backend, typename Listener>
+inline auto BasicBook<Backend, Listener>::limit_sell(order_size size, order_price price) -> OrderIDType
 {
     return common_add_order<order_type::LIM_SELL>(size, price);
 }
-inline auto Book::fok_buy(order_size size, order_price price) -> bool
+template <typename Backend, typename Listener>
+inline auto BasicBook<Backend, Listener>::fok_buy(order_size size, order_price price) -> bool
 {
     return common_fok_order<order_type::FOK_BUY>(size, price);
 }
-inline auto Book::fok_sell(order_size size, order_price price) -> bool
+template <typename Backend, typename Listener>
+inline auto BasicBook<Backend, Listener>::fok_sell(order_size size, order_price price) -> bool
 {
     return common_fok_order<order_type::FOK_SELL>(size, price);
 }
 
-inline auto Book::cancel_order(OrderIDType id) -> bool
+template <typename Backend, typename Listener>
+inline auto BasicBook<Backend, Listener>::cancel_order(OrderIDType id) -> bool
 {
-    if (order_list.find(id) == order_list.end())
+    auto o = order_list.erase(id);
+
+    if (!o)
         return false;
 
-    auto o = order_list[id];
-    order_list.erase(id);
+    auto level = o->level;
+    level->erase(o);
 
     if (o->type == order_type::LIM_BUY)
-        buy_book.erase(o);
+    {
+        buy_book.depth -= o->size;
+
+        if (level->empty())
+            buy_book.remove(level);
+    }
     else
-        sell_book.erase(o);
+    {
+        sell_book.depth -= o->size;
+
+        if (level->empty())
+            sell_book.remove(level);
+    }
 
-    delete o;
+    m_pool.release(o);
 
     return true;   
 }
 
-inline auto Book::post_order_complete_callback(order_complete_cb cb) -> void
+template <typename Backend, typename Listener>
+inline auto BasicBook<Backend, Listener>::post_order_complete_callback(order_complete_cb cb) -> void
 {
     _cb = cb;
     return;
 }
+
+template <typename Backend, typename Listener>
+inline auto BasicBook<Backend, Listener>::post_fill_batch_callback(fill_batch_cb cb) -> void
+{
+    m_batch_cb = cb;
+}
+
+template <typename Backend, typename Listener>
+inline auto BasicBook<Backend, Listener>::set_matching_mode(matching_mode mode) -> void
+{
+    if (mode == matching_mode::CONTINUOUS && m_mode == matching_mode::CALL_AUCTION)
+        uncross();
+
+    m_mode = mode;
+}
+
+// Merges the levels between the best ask and the best bid, the only prices
+// an auction could clear at, into ascending price order with each side's
+// volume at each.
+template <typename Backend, typename Listener>
+inline auto BasicBook<Backend, Listener>::collect_crossing_depth() -> void
+{
+    m_auction_prices.clear();
+    m_auction_bids.clear();
+    m_auction_asks.clear();
+    m_crossing_bids.clear();
+
+    auto lowest_ask = sell_book.best()->price;
+    auto highest_bid = buy_book.best()->price;
+
+    for (auto level = buy_book.best(); level && level->price >= lowest_ask; level = buy_book.next(level))
+        m_crossing_bids.push_back(level);
+
+    auto bid = m_crossing_bids.rbegin();
+    auto ask = sell_book.best();
+
+    while (bid != m_crossing_bids.rend() || (ask && ask->price <= highest_bid))
+    {
+        auto ask_crosses = ask && ask->price <= highest_bid;
+        auto price = bid == m_crossing_bids.rend() ? ask->price :
+                     ask_crosses ? std::min((*bid)->price, ask->price) :
+                     (*bid)->price;
+
+        auto bid_volume = level_volume{0};
+        auto ask_volume = level_volume{0};
+
+        if (bid != m_crossing_bids.rend() && (*bid)->price == price)
+            bid_volume = (*bid++)->volume;
+
+        if (ask_crosses && ask->price == price)
+        {
+            ask_volume = ask->volume;
+            ask = sell_book.next(ask);
+        }
+
+        m_auction_prices.push_back(price);
+        m_auction_bids.push_back(bid_volume);
+        m_auction_asks.push_back(ask_volume);
+    }
+}
+
+// Fills volume from one side, best price first, every order at price.
+template <typename Backend, typename Listener>
+template <order_type OrderType>
+inline auto BasicBook<Backend, Listener>::execute_auction(level_volume volume, order_price price) -> void
+{
+    auto& same_book = get_order_book<OrderType>();
+    constexpr auto counterparty = OrderType == order_type::LIM_BUY ? order_type::LIM_SELL : order_type::LIM_BUY;
+
+    while (volume)
+    {
+        auto level = same_book.best();
+        auto resting = level->head;
+
+        while (volume && resting)
+        {
+            auto next = resting->next;
+            auto filled = static_cast<order_size>(std::min<level_volume>(volume, resting->size));
+            volume -= filled;
+            same_book.depth -= filled;
+
+            auto& fill = m_fills.emplace_back(resting->id,
+                                              filled,
+                                              price,
+                                              resting->size - filled,
+                                              counterparty,
+                                              price);
+            m_listener.on_fill(fill);
+
+            if (filled == resting->size)
+            {
+                level->erase(resting);
+                order_list.erase(resting->id);
+                m_pool.release(resting);
+            }
+            else
+            {
+                resting->size -= filled;
+                level->volume -= filled;
+            }
+
+            resting = next;
+        }
+
+        if (level->empty())
+            same_book.remove(level);
+    }
+}
+
+template <typename Backend, typename Listener>
+inline auto BasicBook<Backend, Listener>::uncross() -> auction_result
+{
+    m_fills.clear();
+
+    auto bid = buy_book.best();
+    auto ask = sell_book.best();
+
+    if (!bid || !ask || bid->price < ask->price)
+        return {};
+
+    collect_crossing_depth();
+
+    auto clearing = find_clearing_price(m_auction_bids, m_auction_asks);
+    auto result = auction_result{m_auction_prices[clearing.index], clearing.volume};
+
+    execute_auction<order_type::LIM_BUY>(result.volume, result.price);
+    execute_auction<order_type::LIM_SELL>(result.volume, result.price);
+
+    publish_fills();
+
+    return result;
+}
+
+template <typename Backend, typename Listener>
+template <book_side Side>
+inline auto BasicBook<Backend, Listener>::collect_side() -> std::vector<order_snapshot>
+{
+    auto& side = get_order_book<Side == book_side::BUY ? order_type::LIM_BUY : order_type::LIM_SELL>();
+    auto orders = std::vector<order_snapshot>{};
+
+    for (auto level = side.best(); level; level = side.next(level))
+        for (auto o = level->head; o; o = o->next)
+            orders.push_back({o->id, o->size, o->price});
+
+    return orders;
+}
+
+template <typename Backend, typename Listener>
+inline auto BasicBook<Backend, Listener>::save(std::ostream& out) -> bool
+{
+    auto bids = collect_side<book_side::BUY>();
+    auto asks = collect_side<book_side::SELL>();
+    auto header = book_snapshot_header{book_snapshot_header::MAGIC, m_ids.peek(), bids.size(), asks.size()};
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(bids.data()), bids.size() * sizeof(order_snapshot));
+    out.write(reinterpret_cast<const char*>(asks.data()), asks.size() * sizeof(order_snapshot));
+
+    return static_cast<bool>(out);
+}
+
+// Appends orders, already in priority order, to one side. Rejects any out of
+// order, as they would not match the way they did before.
+template <typename Backend, typename Listener>
+template <order_type OrderType>
+inline auto BasicBook<Backend, Listener>::restore_side(std::span<const order_snapshot> orders) -> bool
+{
+    auto& same_book = get_order_book<OrderType>();
+    constexpr auto better = get_is_better<OrderType>();
+    price_level* level = nullptr;
+
+    for (const auto& snapshot: orders)
+    {
+        if (!snapshot.id || !snapshot.size || !same_book.accepts(snapshot.price) || order_list.find(snapshot.id))
+            return false;
+
+        if (!level || level->price != snapshot.price)
+        {
+            if (level && better(snapshot.price, level->price))
+                return false;
+
+            level = &same_book.get_or_insert(snapshot.price);
+        }
+
+        auto o = build_order<OrderType>(m_pool, snapshot.id, snapshot.size, snapshot.price);
+        level->push_back(o);
+        same_book.depth += snapshot.size;
+        order_list.insert(o->id, o);
+    }
+
+    return true;
+}
+
+template <typename Backend, typename Listener>
+inline auto BasicBook<Backend, Listener>::restore(std::istream& in) -> bool
+{
+    if (order_list.size())
+        return false;
+
+    auto header = book_snapshot_header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (!in || header.magic != book_snapshot_header::MAGIC)
+        return false;
+
+    auto count = header.bid_count + header.ask_count;
+
+    if (count < header.bid_count)
+        return false;
+
+    // The counts come from the file, so orders are read a chunk at a time
+    // and never allocated ahead of the data actually there.
+    auto orders = std::vector<order_snapshot>{};
+
+    while (orders.size() < count)
+    {
+        auto read = orders.size();
+        orders.resize(read + std::min<uint64_t>(count - read, SNAPSHOT_READ_CHUNK));
+        in.read(reinterpret_cast<char*>(orders.data() + read), (orders.size() - read) * sizeof(order_snapshot));
+
+        if (!in)
+            return false;
+    }
+
+    // Ids handed out after restoring must not collide with restored ones.
+    for (const auto& snapshot: orders)
+        if (snapshot.id >= header.next_id)
+            return false;
+
+    m_pool.reserve(orders.size());
+    order_list.reserve(orders.size());
+
+    auto all = std::span<const order_snapshot>{orders};
+
+    if (!restore_side<order_type::LIM_BUY>(all.first(header.bid_count)) ||
+        !restore_side<order_type::LIM_SELL>(all.subspan(header.bid_count)))
+    {
+        clear();
+        return false;
+    }
+
+    m_ids.resume_from(header.next_id);
+
+    return true;
+}
+
+template <typename Backend, typename Listener>
+inline auto BasicBook<Backend, Listener>::clear() -> void
+{
+    while (auto level = buy_book.best())
+        cancel_order(level->head->id);
+
+    while (auto level = sell_book.best())
+        cancel_order(level->head->id);
+}
+
+// Bounded tick range backend for instruments whose prices are known to fit
+// in [0, BOOK_LADDER_MAX_PRICE].
+#ifdef BOOK_PRICE_LADDER
+using default_backend = ladder_backend<BOOK_LADDER_MAX_PRICE>;
+#else
+using default_backend = map_backend;
+#endif
+
+using Book = BasicBook<default_backend>;
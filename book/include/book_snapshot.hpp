@@ -0,0 +1,32 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "order.hpp"
+
+// Layout of a snapshot written by BasicBook::save(), in host byte order:
+//
+//     book_snapshot_header | bid orders | ask orders
+//
+// Each side's orders are listed best price first, and in time priority
+// within a price, so a book is rebuilt by appending them in turn.
+struct book_snapshot_header
+{
+    static constexpr std::array<char, 8> MAGIC = {'B', 'O', 'O', 'K', 'S', 'N', 'P', '1'};
+
+    std::array<char, 8> magic;
+    // State of the book's order_id_generator.
+    order_id next_id;
+    uint64_t bid_count;
+    uint64_t ask_count;
+};
+
+struct order_snapshot
+{
+    order_id id;
+    order_size size;
+    order_price price;
+};
+
+static_assert(sizeof(order_snapshot) == 16);
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "price_level.hpp"
+
+// Outcome of uncrossing a call auction: everything traded at one price.
+// volume is zero when the book was not crossed.
+struct auction_result
+{
+    order_price price = 0;
+    level_volume volume = 0;
+};
+
+struct clearing_result
+{
+    // Index into the candidate prices the auction clears at.
+    std::size_t index = 0;
+    level_volume volume = 0;
+};
+
+// Kernels picking the clearing price from the aggregate depth at each
+// candidate price, ascending: bids[i] and asks[i] are the volume resting at
+// the i-th price on each side. Demand at a price is the bid volume at or
+// above it, supply the ask volume at or below it, and min(demand, supply)
+// trades. The price that trades the most wins, ties going to the smallest
+// imbalance between demand and supply, then to the lowest price. Total
+// volume on a side must stay below 2^63.
+//
+// Supply only grows with price and demand only shrinks, so volume traded
+// rises to the last price where supply is at most demand and falls after
+// it. Kernels differ only in how fast they find that crossing; the winner is
+// then one of the two prices either side of it.
+namespace clearing_kernels
+{
+
+// Picks between the prices either side of crossing, the first index whose
+// supply exceeds its demand, given demand at it and supply before it.
+inline auto settle(std::span<const level_volume> bids,
+                   std::span<const level_volume> asks,
+                   std::size_t crossing,
+                   level_volume demand,
+                   level_volume supply) -> clearing_result
+{
+    auto best = clearing_result{};
+    auto best_imbalance = ~level_volume{0};
+
+    if (crossing > 0)
+    {
+        // All of the supply trades. Lower prices with no depth between them
+        // and this one trade the same with the same imbalance, and the
+        // lowest of those wins.
+        auto index = crossing - 1;
+        best_imbalance = demand + bids[index] - supply;
+
+        while (index && !bids[index - 1] && !asks[index])
+            index--;
+
+        best = {index, supply};
+    }
+
+    if (crossing < bids.size())
+    {
+        // All of the demand trades.
+        auto imbalance = supply + asks[crossing] - demand;
+
+        if (demand > best.volume || (demand == best.volume && imbalance < best_imbalance))
+            best = {crossing, demand};
+    }
+
+    if (!best.volume)
+        return {};
+
+    return best;
+}
+
+// Walks from index first, given demand at it and supply before it, to the
+// crossing.
+inline auto find_crossing(std::span<const level_volume> bids,
+                          std::span<const level_volume> asks,
+                          std::size_t first,
+                          level_volume demand,
+                          level_volume supply) -> clearing_result
+{
+    auto i = first;
+
+    for (; i < bids.size() && supply + asks[i] <= demand; i++)
+    {
+        supply += asks[i];
+        demand -= bids[i];
+    }
+
+    return settle(bids, asks, i, demand, supply);
+}
+
+inline auto total(std::span<const level_volume> volumes) -> level_volume
+{
+    auto sum = level_volume{0};
+
+    for (auto volume: volumes)
+        sum += volume;
+
+    return sum;
+}
+
+inline auto scalar(std::span<const level_volume> bids, std::span<const level_volume> asks) -> clearing_result
+{
+    return find_crossing(bids, asks, 0, total(bids), 0);
+}
+
+#if defined(__x86_64__)
+
+[[gnu::target("avx2")]] inline auto horizontal_sum(__m256i x) -> level_volume
+{
+    auto half = _mm_add_epi64(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+    return static_cast<level_volume>(_mm_cvtsi128_si64(_mm_add_epi64(half, _mm_unpackhi_epi64(half, half))));
+}
+
+// Sum of the four vectors of volumes from first, lane by lane.
+[[gnu::target("avx2")]] inline auto chunk_sum(const level_volume* first) -> __m256i
+{
+    auto vectors = reinterpret_cast<const __m256i*>(first);
+
+    return _mm256_add_epi64(_mm256_add_epi64(_mm256_loadu_si256(vectors), _mm256_loadu_si256(vectors + 1)),
+                            _mm256_add_epi64(_mm256_loadu_si256(vectors + 2), _mm256_loadu_si256(vectors + 3)));
+}
+
+// Skips 16 prices at a time while supply stays at most demand through the
+// last of them, which only needs the chunk's bid and ask totals. Supply
+// minus demand at a price is the bids before it and the asks up to it less
+// all bids, so one running sum of both covers it. The chunk the crossing
+// falls in is walked a price at a time.
+[[gnu::target("avx2")]] inline auto avx2(std::span<const level_volume> bids, std::span<const level_volume> asks) -> clearing_result
+{
+    constexpr auto CHUNK = std::size_t{16};
+
+    auto all_bids = total(bids);
+    auto consumed = level_volume{0};
+    auto asks_before = _mm256_setzero_si256();
+    auto i = std::size_t{0};
+
+    for (; i + CHUNK <= bids.size(); i += CHUNK)
+    {
+        auto chunk_asks = chunk_sum(asks.data() + i);
+        auto chunk = horizontal_sum(_mm256_add_epi64(chunk_asks, chunk_sum(bids.data() + i)));
+
+        if (consumed + chunk > all_bids + bids[i + CHUNK - 1])
+            break;
+
+        consumed += chunk;
+        asks_before = _mm256_add_epi64(asks_before, chunk_asks);
+    }
+
+    auto supply = horizontal_sum(asks_before);
+    auto demand = all_bids - (consumed - supply);
+
+    return find_crossing(bids, asks, i, demand, supply);
+}
+
+#endif
+
+using kernel = clearing_result (*)(std::span<const level_volume>, std::span<const level_volume>);
+
+// The widest kernel this CPU runs, chosen on first use.
+inline auto select() -> kernel
+{
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2"))
+        return avx2;
+#endif
+
+    return scalar;
+}
+
+}
+
+inline auto find_clearing_price(std::span<const level_volume> bids,
+                                std::span<const level_volume> asks) -> clearing_result
+{
+    static const auto kernel = clearing_kernels::select();
+    return kernel(bids, asks);
+}
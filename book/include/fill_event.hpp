@@ -0,0 +1,23 @@
+#pragma once
+
+#include "order.hpp"
+
+// One execution against a resting order, as recorded by the matching engine.
+struct fill_event
+{
+    order_id resting_id;
+    // Volume traded and the (resting) price it traded at.
+    order_size size;
+    order_price price;
+    // Size left on the resting order, zero once it has been fully filled.
+    order_size resting_remaining;
+    order_type aggressor_type;
+    order_price aggressor_price;
+};
+
+// Default listener policy for BasicBook: ignores fills as they happen, they
+// are still available from the book's fill buffer once the match completes.
+struct no_fill_listener
+{
+    auto on_fill(const fill_event&) -> void {}
+};
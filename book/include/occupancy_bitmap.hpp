@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+// Hierarchical set of bits. Each 64 bit word of the bottom layer is summarised
+// by one bit in the layer above, so finding the lowest/highest set bit or the
+// nearest set bit to a position costs one countr_zero/countl_zero per layer.
+template <std::size_t Bits>
+class occupancy_bitmap
+{
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    auto set(std::size_t i) -> void
+    {
+        m_words[i / 64] |= bit(i);
+
+        if constexpr (has_summary)
+            m_summary.set(i / 64);
+    }
+
+    auto reset(std::size_t i) -> void
+    {
+        m_words[i / 64] &= ~bit(i);
+
+        if constexpr (has_summary)
+            if (!m_words[i / 64])
+                m_summary.reset(i / 64);
+    }
+
+    auto test(std::size_t i) const -> bool
+    {
+        return m_words[i / 64] & bit(i);
+    }
+
+    auto lowest() const -> std::size_t
+    {
+        auto w = std::size_t{0};
+
+        if constexpr (has_summary)
+        {
+            w = m_summary.lowest();
+
+            if (w == npos)
+                return npos;
+        }
+        else if (!m_words[0])
+            return npos;
+
+        return w * 64 + std::countr_zero(m_words[w]);
+    }
+
+    auto highest() const -> std::size_t
+    {
+        auto w = std::size_t{0};
+
+        if constexpr (has_summary)
+        {
+            w = m_summary.highest();
+
+            if (w == npos)
+                return npos;
+        }
+        else if (!m_words[0])
+            return npos;
+
+        return w * 64 + 63 - std::countl_zero(m_words[w]);
+    }
+
+    // Lowest set bit strictly above i.
+    auto next_after(std::size_t i) const -> std::size_t
+    {
+        auto w = i / 64;
+        auto b = i % 64;
+        auto above = b == 63 ? 0 : m_words[w] & (~uint64_t{0} << (b + 1));
+
+        if (above)
+            return w * 64 + std::countr_zero(above);
+
+        if constexpr (has_summary)
+        {
+            w = m_summary.next_after(w);
+
+            if (w != npos)
+                return w * 64 + std::countr_zero(m_words[w]);
+        }
+
+        return npos;
+    }
+
+    // Highest set bit strictly below i.
+    auto prev_before(std::size_t i) const -> std::size_t
+    {
+        auto w = i / 64;
+        auto b = i % 64;
+        auto below = m_words[w] & ((uint64_t{1} << b) - 1);
+
+        if (below)
+            return w * 64 + 63 - std::countl_zero(below);
+
+        if constexpr (has_summary)
+        {
+            if (w == 0)
+                return npos;
+
+            w = m_summary.prev_before(w);
+
+            if (w != npos)
+                return w * 64 + 63 - std::countl_zero(m_words[w]);
+        }
+
+        return npos;
+    }
+
+private:
+    static constexpr std::size_t word_count = (Bits + 63) / 64;
+    static constexpr bool has_summary = word_count > 1;
+
+    struct no_summary {};
+
+    static constexpr auto bit(std::size_t i) -> uint64_t
+    {
+        return uint64_t{1} << (i % 64);
+    }
+
+    std::array<uint64_t, word_count> m_words{};
+    [[no_unique_address]]
+    std::conditional_t<has_summary, occupancy_bitmap<word_count>, no_summary> m_summary{};
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+using order_id = uint64_t;
+using order_size = uint32_t;
+using order_price = uint32_t;
+
+enum class order_type
+{
+    LIM_BUY,
+    LIM_SELL,
+    FOK_BUY,
+    FOK_SELL
+};
+
+struct price_level;
+
+struct order
+{
+    order_id id;
+    order_size size;
+    order_price price;
+    order_type type;
+
+    // Intrusive links into the FIFO of the price level the order rests at.
+    order* prev;
+    order* next;
+    price_level* level;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+#include "order.hpp"
+
+// Monotonic per-book order ids. The top PREFIX_BITS carry an optional shard or
+// instrument prefix so that books sharing an id space never collide. Ids start
+// at 1 so that 0 is never handed out.
+class order_id_generator
+{
+public:
+    static constexpr unsigned PREFIX_BITS = 16;
+    static constexpr unsigned SEQUENCE_BITS = 64 - PREFIX_BITS;
+
+    explicit order_id_generator(uint16_t prefix = 0):
+        m_next((order_id{prefix} << SEQUENCE_BITS) | 1)
+    {}
+
+    auto next() -> order_id
+    {
+        return m_next++;
+    }
+
+    // The id next() will hand out, for snapshots.
+    auto peek() const -> order_id
+    {
+        return m_next;
+    }
+
+    auto resume_from(order_id next) -> void
+    {
+        m_next = next;
+    }
+
+    static constexpr auto prefix_of(order_id id) -> uint16_t
+    {
+        return static_cast<uint16_t>(id >> SEQUENCE_BITS);
+    }
+
+private:
+    order_id m_next;
+};
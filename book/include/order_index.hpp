@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "order.hpp"
+
+// Open addressing id -> order table with linear probing. Id 0 marks an empty
+// slot, and erase shifts the following cluster back rather than leaving
+// tombstones, so lookups never degrade with churn. Grows at half load.
+class order_index
+{
+public:
+    explicit order_index(std::size_t expected_orders = 0)
+    {
+        rehash(std::bit_ceil(std::max<std::size_t>(MIN_CAPACITY, expected_orders * 2)));
+    }
+
+    auto insert(order_id id, order* o) -> void
+    {
+        if ((m_size + 1) * 2 > m_slots.size())
+            rehash(m_slots.size() * 2);
+
+        place(id, o);
+        m_size++;
+    }
+
+    // Makes room for orders entries in total without growing again.
+    auto reserve(std::size_t orders) -> void
+    {
+        auto capacity = std::bit_ceil(std::max<std::size_t>(MIN_CAPACITY, orders * 2));
+
+        if (capacity > m_slots.size())
+            rehash(capacity);
+    }
+
+    auto find(order_id id) const -> order*
+    {
+        for (auto i = home(id);; i = (i + 1) & m_mask)
+        {
+            if (m_slots[i].id == id)
+                return m_slots[i].o;
+
+            if (m_slots[i].id == 0)
+                return nullptr;
+        }
+    }
+
+    // Removes and returns the order stored under id, or nullptr if absent.
+    auto erase(order_id id) -> order*
+    {
+        if (id == 0)
+            return nullptr;
+
+        auto i = home(id);
+
+        while (m_slots[i].id != id)
+        {
+            if (m_slots[i].id == 0)
+                return nullptr;
+
+            i = (i + 1) & m_mask;
+        }
+
+        auto o = m_slots[i].o;
+
+        // Pull back any later entry of the cluster whose home does not lie
+        // cyclically in (i, j], so that every entry stays reachable.
+        for (auto j = (i + 1) & m_mask; m_slots[j].id != 0; j = (j + 1) & m_mask)
+        {
+            auto h = home(m_slots[j].id);
+
+            if (((j - h) & m_mask) >= ((j - i) & m_mask))
+            {
+                m_slots[i] = m_slots[j];
+                i = j;
+            }
+        }
+
+        m_slots[i] = {};
+        m_size--;
+
+        return o;
+    }
+
+    auto size() const -> std::size_t
+    {
+        return m_size;
+    }
+
+private:
+    static constexpr std::size_t MIN_CAPACITY = 64;
+
+    struct slot
+    {
+        order_id id;
+        order* o;
+    };
+
+    std::vector<slot> m_slots;
+    std::size_t m_mask = 0;
+    unsigned m_shift = 0;
+    std::size_t m_size = 0;
+
+    // Fibonacci hashing spreads the sequential ids handed out by
+    // order_id_generator across the table.
+    auto home(order_id id) const -> std::size_t
+    {
+        return (id * 0x9E3779B97F4A7C15ull) >> m_shift;
+    }
+
+    auto place(order_id id, order* o) -> void
+    {
+        auto i = home(id);
+
+        while (m_slots[i].id != 0)
+            i = (i + 1) & m_mask;
+
+        m_slots[i] = { id, o };
+    }
+
+    auto rehash(std::size_t capacity) -> void
+    {
+        auto old = std::move(m_slots);
+        m_slots.assign(capacity, slot{});
+        m_mask = capacity - 1;
+        m_shift = 64 - std::countr_zero(capacity);
+
+        for (auto& s: old)
+            if (s.id != 0)
+                place(s.id, s.o);
+    }
+};
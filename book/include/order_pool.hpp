@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "order.hpp"
+
+// Slab allocator for resting orders. Slabs are only ever added, so an order's
+// address is stable for as long as it is live, and released orders are kept
+// on an intrusive free list (through order::next) for reuse. Once the pool
+// has grown to the working set no further system allocations happen.
+class order_pool
+{
+public:
+    static constexpr std::size_t DEFAULT_SLAB_SIZE = 4096;
+
+    struct stats
+    {
+        std::size_t capacity;
+        std::size_t in_use;
+        std::size_t high_water_mark;
+        std::size_t slabs;
+    };
+
+    explicit order_pool(std::size_t initial_capacity = DEFAULT_SLAB_SIZE,
+                        std::size_t slab_size = DEFAULT_SLAB_SIZE):
+        m_slab_size(slab_size ? slab_size : DEFAULT_SLAB_SIZE)
+    {
+        if (initial_capacity)
+            add_slab(initial_capacity);
+    }
+
+    order_pool(const order_pool& other) = delete;
+    order_pool& operator=(const order_pool& other) = delete;
+
+    order_pool(order_pool&& other) noexcept:
+        m_slab_size(other.m_slab_size),
+        m_slabs(std::move(other.m_slabs)),
+        m_free(std::exchange(other.m_free, nullptr)),
+        m_capacity(std::exchange(other.m_capacity, 0)),
+        m_in_use(std::exchange(other.m_in_use, 0)),
+        m_high_water_mark(std::exchange(other.m_high_water_mark, 0))
+    {}
+
+    order_pool& operator=(order_pool&& other) noexcept
+    {
+        m_slab_size = other.m_slab_size;
+        m_slabs = std::move(other.m_slabs);
+        m_free = std::exchange(other.m_free, nullptr);
+        m_capacity = std::exchange(other.m_capacity, 0);
+        m_in_use = std::exchange(other.m_in_use, 0);
+        m_high_water_mark = std::exchange(other.m_high_water_mark, 0);
+        return *this;
+    }
+
+    auto acquire() -> order*
+    {
+        if (!m_free)
+            add_slab(m_slab_size);
+
+        auto o = m_free;
+        m_free = o->next;
+        *o = order{};
+
+        if (++m_in_use > m_high_water_mark)
+            m_high_water_mark = m_in_use;
+
+        return o;
+    }
+
+    auto release(order* o) -> void
+    {
+        o->next = m_free;
+        m_free = o;
+        m_in_use--;
+    }
+
+    // Makes sure orders more can be acquired with at most one allocation.
+    auto reserve(std::size_t orders) -> void
+    {
+        if (auto free = m_capacity - m_in_use; free < orders)
+            add_slab(orders - free);
+    }
+
+    auto get_stats() const -> stats
+    {
+        return { m_capacity, m_in_use, m_high_water_mark, m_slabs.size() };
+    }
+
+private:
+    std::size_t m_slab_size;
+    std::vector<std::unique_ptr<order[]>> m_slabs;
+    order* m_free = nullptr;
+    std::size_t m_capacity = 0;
+    std::size_t m_in_use = 0;
+    std::size_t m_high_water_mark = 0;
+
+    auto add_slab(std::size_t size) -> void
+    {
+        auto& slab = m_slabs.emplace_back(std::make_unique_for_overwrite<order[]>(size));
+
+        // Thread back to front so orders are handed out in address order.
+        for (auto i = size; i-- > 0;)
+        {
+            slab[i].next = m_free;
+            m_free = &slab[i];
+        }
+
+        m_capacity += size;
+    }
+};
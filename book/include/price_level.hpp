@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+#include "order.hpp"
+
+using level_volume = uint64_t;
+
+// All resting orders at a single price, kept in time priority. Orders are
+// linked intrusively so queueing and unlinking never allocate.
+struct price_level
+{
+    order_price price;
+    order* head = nullptr;
+    order* tail = nullptr;
+    // Sum of the sizes of the queued orders.
+    level_volume volume = 0;
+
+    auto empty() const -> bool
+    {
+        return head == nullptr;
+    }
+
+    auto push_back(order* o) -> void
+    {
+        o->level = this;
+        o->next = nullptr;
+        o->prev = tail;
+
+        if (tail)
+            tail->next = o;
+        else
+            head = o;
+
+        tail = o;
+        volume += o->size;
+    }
+
+    auto erase(order* o) -> void
+    {
+        if (o->prev)
+            o->prev->next = o->next;
+        else
+            head = o->next;
+
+        if (o->next)
+            o->next->prev = o->prev;
+        else
+            tail = o->prev;
+
+        volume -= o->size;
+        o->prev = nullptr;
+        o->next = nullptr;
+        o->level = nullptr;
+    }
+};
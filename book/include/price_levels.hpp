@@ -0,0 +1,160 @@
+#pragma once
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <format>
+#include <functional>
+#include <stdexcept>
+
+#include "order.hpp"
+#include "price_level.hpp"
+#include "occupancy_bitmap.hpp"
+
+// Level stores used by BasicBook. Each side of the book owns one and only
+// needs: the best level, the next worse level, level lookup/creation by price
+// and removal of a level once its queue has emptied. Each also carries the
+// total resting volume on its side, which the book keeps up to date.
+
+enum class book_side
+{
+    BUY,
+    SELL
+};
+
+// Unbounded price range, levels kept in a red-black tree. A hash of each
+// level's tree position makes finding an existing level, and stepping to the
+// next, O(1); only creating and removing a level walks the tree.
+template <book_side Side>
+class map_levels
+{
+public:
+    level_volume depth = 0;
+
+    auto best() -> price_level*
+    {
+        if (m_levels.empty())
+            return nullptr;
+
+        return &m_levels.begin()->second;
+    }
+
+    auto next(price_level* level) -> price_level*
+    {
+        auto it = std::next(m_positions.find(level->price)->second);
+
+        if (it == m_levels.end())
+            return nullptr;
+
+        return &it->second;
+    }
+
+    static auto accepts(order_price) -> bool
+    {
+        return true;
+    }
+
+    auto get_or_insert(order_price price) -> price_level&
+    {
+        if (auto found = m_positions.find(price); found != m_positions.end())
+            return found->second->second;
+
+        auto it = m_levels.try_emplace(price).first;
+        it->second.price = price;
+        m_positions.emplace(price, it);
+
+        return it->second;
+    }
+
+    auto remove(price_level* level) -> void
+    {
+        auto found = m_positions.find(level->price);
+        m_levels.erase(found->second);
+        m_positions.erase(found);
+    }
+
+private:
+    using Compare = std::conditional_t<Side == book_side::BUY,
+                                       std::greater<order_price>,
+                                       std::less<order_price>>;
+    using Levels = std::map<order_price, price_level, Compare>;
+
+    Levels m_levels;
+    std::unordered_map<order_price, typename Levels::iterator> m_positions;
+};
+
+// Bounded price range [0, MaxPrice], levels indexed directly by price with an
+// occupancy bitmap to find the best and next levels.
+template <book_side Side, order_price MaxPrice>
+class ladder_levels
+{
+public:
+    level_volume depth = 0;
+
+    ladder_levels():
+        m_levels(std::size_t{MaxPrice} + 1)
+    {
+        for (auto price = order_price{0}; auto& level: m_levels)
+            level.price = price++;
+    }
+
+    auto best() -> price_level*
+    {
+        if constexpr (Side == book_side::BUY)
+            return at(m_occupied.highest());
+        else
+            return at(m_occupied.lowest());
+    }
+
+    auto next(price_level* level) -> price_level*
+    {
+        if constexpr (Side == book_side::BUY)
+            return at(m_occupied.prev_before(level->price));
+        else
+            return at(m_occupied.next_after(level->price));
+    }
+
+    static auto accepts(order_price price) -> bool
+    {
+        return price <= MaxPrice;
+    }
+
+    auto get_or_insert(order_price price) -> price_level&
+    {
+        if (price > MaxPrice)
+            throw std::out_of_range(std::format("Price {} is outside the ladder range.", price));
+
+        m_occupied.set(price);
+        return m_levels[price];
+    }
+
+    auto remove(price_level* level) -> void
+    {
+        m_occupied.reset(level->price);
+    }
+
+private:
+    std::vector<price_level> m_levels;
+    occupancy_bitmap<std::size_t{MaxPrice} + 1> m_occupied;
+
+    auto at(std::size_t index) -> price_level*
+    {
+        if (index == decltype(m_occupied)::npos)
+            return nullptr;
+
+        return &m_levels[index];
+    }
+};
+
+struct map_backend
+{
+    template <book_side Side>
+    using levels = map_levels<Side>;
+};
+
+template <order_price MaxPrice>
+struct ladder_backend
+{
+    template <book_side Side>
+    using levels = ladder_levels<Side, MaxPrice>;
+};
@@ -0,0 +1,101 @@
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "clearing_price.hpp"
+
+namespace
+{
+
+struct depth
+{
+    std::vector<level_volume> bids;
+    std::vector<level_volume> asks;
+};
+
+// Random depth with about half of the prices empty on each side, so the
+// clearing price falls near the middle.
+auto random_depth(std::size_t levels, std::mt19937_64& rng) -> depth
+{
+    auto result = depth{std::vector<level_volume>(levels), std::vector<level_volume>(levels)};
+
+    for (auto i = std::size_t{0}; i < levels; i++)
+    {
+        result.bids[i] = rng() % 2 ? rng() % 1000 : 0;
+        result.asks[i] = rng() % 2 ? rng() % 1000 : 0;
+    }
+
+    return result;
+}
+
+// Nanoseconds per call, calling repeatedly for at least a tenth of a second.
+auto time_kernel(clearing_kernels::kernel kernel, const depth& depth) -> double
+{
+    auto calls = std::size_t{0};
+    auto checksum = level_volume{0};
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::steady_clock::duration{};
+
+    do
+    {
+        for (auto i = 0; i < 64; i++)
+            checksum += kernel(depth.bids, depth.asks).index;
+
+        calls += 64;
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    while (elapsed < std::chrono::milliseconds{100});
+
+    // Keeps the calls from being optimized away.
+    if (checksum == 1)
+        std::cout << "";
+
+    return std::chrono::duration<double, std::nano>(elapsed).count() / calls;
+}
+
+}
+
+// clearing_price_bench [levels...]
+//
+// Times each clearing price kernel this CPU can run against the scalar
+// baseline, over random depth at each number of candidate price levels.
+int main(int argc, const char *argv[])
+{
+    auto sizes = std::vector<std::size_t>{};
+
+    for (auto i = 1; i < argc; i++)
+        sizes.push_back(std::stoull(argv[i]));
+
+    if (sizes.empty())
+        sizes = {8, 32, 128, 512, 2048, 8192, 32768};
+
+    auto rng = std::mt19937_64{1};
+    auto selected = clearing_kernels::select();
+
+    std::cout << std::format("Selected kernel:    {}\n", selected == clearing_kernels::scalar ? "scalar" : "avx2");
+
+    for (auto levels: sizes)
+    {
+        auto depth = random_depth(levels, rng);
+
+        auto expected = clearing_kernels::scalar(depth.bids, depth.asks);
+        auto result = selected(depth.bids, depth.asks);
+
+        if (result.index != expected.index || result.volume != expected.volume)
+        {
+            std::cerr << std::format("Kernels disagree at {} levels.\n", levels);
+            return 1;
+        }
+
+        auto scalar = time_kernel(clearing_kernels::scalar, depth);
+        auto chosen = time_kernel(selected, depth);
+
+        std::cout << std::format("{:>6} levels:  scalar {:.1f} ns, selected {:.1f} ns, {:.2f}x\n",
+                                 levels, scalar, chosen, scalar / chosen);
+    }
+
+    return 0;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+// C++
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+namespace exchange
+{
+
+// Codecs tell the socket transports how a message type is framed on the wire:
+//
+//     max_frame_size<T>        upper bound on an encoded T
+//     frame_size<T>(buffered)  length of the frame at the front of buffered,
+//                              0 if more bytes are needed to tell
+//     encode<T>(value, out)    writes a frame, returns its length
+//     decode<T>(frame, value)  false if the frame is malformed
+//
+// raw_codec sends the object representation as is.
+struct raw_codec
+{
+    template <typename T>
+    static constexpr std::size_t max_frame_size = sizeof(T);
+
+    template <typename T>
+    static auto frame_size(std::span<const std::byte> buffered) -> std::size_t
+    {
+        return buffered.size() < sizeof(T) ? 0 : sizeof(T);
+    }
+
+    template <typename T>
+    requires std::is_trivially_copyable_v<T>
+    static auto encode(const T& value, std::byte* out) -> std::size_t
+    {
+        std::memcpy(out, &value, sizeof(T));
+        return sizeof(T);
+    }
+
+    template <typename T>
+    requires std::is_trivially_copyable_v<T>
+    static auto decode(std::span<const std::byte> frame, T& value) -> bool
+    {
+        std::memcpy(&value, frame.data(), sizeof(T));
+        return true;
+    }
+};
+
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+// C
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+
+// C++
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <vector>
+
+namespace exchange
+{
+
+// Minimal io_uring wrapper over the raw syscalls: submission/completion ring
+// mappings, SQE allocation and batched submit, and CQE iteration.
+class IoUring
+{
+public:
+    explicit IoUring(unsigned entries, unsigned cq_entries = 0)
+    {
+        auto params = io_uring_params{};
+
+        if (cq_entries)
+        {
+            params.flags |= IORING_SETUP_CQSIZE;
+            params.cq_entries = cq_entries;
+        }
+
+        m_fd = syscall(__NR_io_uring_setup, entries, &params);
+
+        if (m_fd == -1)
+            throw std::runtime_error(std::format("Unable to set up io_uring. Errno: {}\n", errno));
+
+        m_sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+            m_sq_size = m_cq_size = std::max(m_sq_size, m_cq_size);
+
+        m_sq_ptr = map(m_sq_size, IORING_OFF_SQ_RING);
+        m_cq_ptr = params.features & IORING_FEAT_SINGLE_MMAP ?
+                        m_sq_ptr :
+                        map(m_cq_size, IORING_OFF_CQ_RING);
+        m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        m_sqes = static_cast<io_uring_sqe*>(map(m_sqes_size, IORING_OFF_SQES));
+
+        auto sq = static_cast<char*>(m_sq_ptr);
+        m_sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        m_sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        m_sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        m_sq_entries = params.sq_entries;
+        auto sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+        // SQEs are always handed out in ring order, so the index array can
+        // be filled in once.
+        for (auto i = 0u; i < m_sq_entries; i++)
+            sq_array[i] = i;
+
+        auto cq = static_cast<char*>(m_cq_ptr);
+        m_cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        m_cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        m_cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        m_local_tail = *m_sq_tail;
+    }
+
+    IoUring(const IoUring& other) = delete;
+    IoUring operator=(const IoUring& other) = delete;
+
+    IoUring(IoUring&& other) = delete;
+    IoUring operator=(IoUring&& other) = delete;
+
+    ~IoUring()
+    {
+        munmap(m_sqes, m_sqes_size);
+
+        if (m_cq_ptr != m_sq_ptr)
+            munmap(m_cq_ptr, m_cq_size);
+
+        munmap(m_sq_ptr, m_sq_size);
+        close(m_fd);
+    }
+
+    auto fd() const -> int
+    {
+        return m_fd;
+    }
+
+    // Next free SQE, zeroed. Submits what is queued if the ring is full.
+    auto get_sqe() -> io_uring_sqe*
+    {
+        if (m_local_tail - head(m_sq_head) == m_sq_entries)
+            submit_and_wait(0);
+
+        auto sqe = &m_sqes[m_local_tail & m_sq_mask];
+        std::memset(sqe, 0, sizeof(io_uring_sqe));
+        m_local_tail++;
+
+        return sqe;
+    }
+
+    // Publishes all queued SQEs and waits for wait_nr completions in a
+    // single io_uring_enter.
+    auto submit_and_wait(unsigned wait_nr) -> int
+    {
+        auto to_submit = m_local_tail - *m_sq_tail;
+        std::atomic_ref{*m_sq_tail}.store(m_local_tail, std::memory_order_release);
+
+        auto flags = wait_nr ? IORING_ENTER_GETEVENTS : 0u;
+
+        while (true)
+        {
+            auto ret = syscall(__NR_io_uring_enter, m_fd, to_submit, wait_nr, flags, nullptr, 0);
+
+            if (ret != -1 || errno != EINTR)
+                return ret;
+        }
+    }
+
+    // Hands every available completion to f, then releases them to the
+    // kernel. Returns the number seen.
+    template <typename F>
+    auto for_each_cqe(F f) -> unsigned
+    {
+        auto h = *m_cq_head;
+        auto t = std::atomic_ref{*m_cq_tail}.load(std::memory_order_acquire);
+
+        for (auto i = h; i != t; i++)
+            f(m_cqes[i & m_cq_mask]);
+
+        std::atomic_ref{*m_cq_head}.store(t, std::memory_order_release);
+
+        return t - h;
+    }
+
+private:
+    int m_fd;
+    void* m_sq_ptr;
+    void* m_cq_ptr;
+    std::size_t m_sq_size;
+    std::size_t m_cq_size;
+    std::size_t m_sqes_size;
+    io_uring_sqe* m_sqes;
+    unsigned* m_sq_head;
+    unsigned* m_sq_tail;
+    unsigned m_sq_mask;
+    unsigned m_sq_entries;
+    unsigned m_local_tail;
+    unsigned* m_cq_head;
+    unsigned* m_cq_tail;
+    unsigned m_cq_mask;
+    io_uring_cqe* m_cqes;
+
+    static auto head(unsigned* p) -> unsigned
+    {
+        return std::atomic_ref{*p}.load(std::memory_order_acquire);
+    }
+
+    auto map(std::size_t size, off_t offset) -> void*
+    {
+        auto addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, offset);
+
+        if (addr == MAP_FAILED)
+            throw std::runtime_error(std::format("Unable to map io_uring. Errno: {}\n", errno));
+
+        return addr;
+    }
+};
+
+// Pool of equally sized receive buffers provided to the kernel as a buffer
+// group. Multishot receives pick a buffer per completion and report its id,
+// recycle() hands it back with the next submission. Provide requests only
+// post a completion on failure.
+class ProvidedBuffers
+{
+public:
+    ProvidedBuffers(IoUring& ring, uint16_t group, unsigned count, unsigned buffer_size, uint64_t user_data):
+        m_ring(ring),
+        m_group(group),
+        m_buffer_size(buffer_size),
+        m_user_data(user_data),
+        m_storage(std::size_t(count) * buffer_size)
+    {
+        provide(0, count);
+    }
+
+    ProvidedBuffers(const ProvidedBuffers& other) = delete;
+    ProvidedBuffers operator=(const ProvidedBuffers& other) = delete;
+
+    auto group() const -> uint16_t
+    {
+        return m_group;
+    }
+
+    auto data(unsigned id) -> char*
+    {
+        return m_storage.data() + std::size_t(id) * m_buffer_size;
+    }
+
+    auto recycle(unsigned id) -> void
+    {
+        provide(id, 1);
+    }
+
+private:
+    IoUring& m_ring;
+    uint16_t m_group;
+    unsigned m_buffer_size;
+    uint64_t m_user_data;
+    std::vector<char> m_storage;
+
+    auto provide(unsigned first_id, unsigned count) -> void
+    {
+        auto sqe = m_ring.get_sqe();
+        sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+        sqe->fd = count;
+        sqe->addr = reinterpret_cast<uint64_t>(data(first_id));
+        sqe->len = m_buffer_size;
+        sqe->off = first_id;
+        sqe->buf_group = m_group;
+        sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+        sqe->user_data = m_user_data;
+    }
+};
+
+}
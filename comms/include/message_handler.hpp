@@ -0,0 +1,213 @@
+#pragma once
+
+// C
+#include <unistd.h>
+
+// C++
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <thread>
+
+#include "mpsc_queue.hpp"
+
+namespace exchange
+{
+
+template <typename ResponseType>
+class Outbox;
+
+// Names the connection a request arrived on so it can be answered later,
+// from any thread.
+template <typename ResponseType>
+struct ReplyAddress
+{
+    Outbox<ResponseType>* outbox;
+    int fd;
+    uint64_t serial;
+
+    auto reply(const ResponseType& response) const -> void;
+
+    // Sends a message that answers no request, such as a fill report.
+    // Waits while the outbox holds as many of these as it has room for.
+    auto notify(const ResponseType& response) const -> void;
+};
+
+template <typename ResponseType>
+struct Reply
+{
+    ReplyAddress<ResponseType> address;
+    ResponseType response;
+    // Not counted against the requests the I/O thread has outstanding.
+    bool unsolicited;
+};
+
+// Responses waiting for the I/O thread that owns their connections. Pushing
+// is lock-free and never enters the kernel, the I/O thread polls for
+// replies while any are outstanding. Unsolicited messages can arrive while
+// it sleeps, so they wake it through wake_fd if it has said it is about to.
+//
+// Replies are bounded by the requests the I/O thread hands off, at most
+// capacity, and unsolicited messages get report_capacity slots of their own
+// on top, so a reply always finds room. Both share one queue to reach the
+// connection in the order they were pushed.
+template <typename ResponseType>
+class Outbox
+{
+public:
+    explicit Outbox(std::size_t capacity, std::size_t report_capacity, int wake_fd = -1):
+        m_queue(capacity + report_capacity),
+        m_report_capacity(report_capacity),
+        m_wake_fd(wake_fd)
+    {}
+
+    auto push(const Reply<ResponseType>& reply) -> void
+    {
+        while (!m_queue.try_push(reply))
+            std::this_thread::yield();
+    }
+
+    // Waits while report_capacity unsolicited messages are queued. The I/O
+    // thread drains the outbox whenever it waits itself, so this cannot
+    // deadlock with it.
+    auto notify(const Reply<ResponseType>& reply) -> void
+    {
+        while (m_reports.fetch_add(1, std::memory_order_acquire) >= m_report_capacity)
+        {
+            m_reports.fetch_sub(1, std::memory_order_relaxed);
+            std::this_thread::yield();
+        }
+
+        push(reply);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (m_sleeping.load(std::memory_order_relaxed) && m_sleeping.exchange(false))
+        {
+            auto one = uint64_t{1};
+            [[maybe_unused]] auto ret = write(m_wake_fd, &one, sizeof(one));
+        }
+    }
+
+    auto try_pop(Reply<ResponseType>& reply) -> bool
+    {
+        if (!m_queue.try_pop(reply))
+            return false;
+
+        if (reply.unsolicited)
+            m_reports.fetch_sub(1, std::memory_order_release);
+
+        return true;
+    }
+
+    // I/O thread only, before it blocks. Returns false if something arrived
+    // in the meantime, in which case it should not.
+    auto prepare_sleep() -> bool
+    {
+        m_sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (m_queue.empty())
+            return true;
+
+        m_sleeping.store(false, std::memory_order_relaxed);
+        return false;
+    }
+
+    auto end_sleep() -> void
+    {
+        m_sleeping.store(false, std::memory_order_relaxed);
+    }
+
+private:
+    MPSCQueue<Reply<ResponseType>> m_queue;
+    std::size_t m_report_capacity;
+    std::atomic<std::size_t> m_reports{0};
+    int m_wake_fd;
+    std::atomic<bool> m_sleeping{false};
+};
+
+template <typename ResponseType>
+auto ReplyAddress<ResponseType>::reply(const ResponseType& response) const -> void
+{
+    outbox->push(Reply<ResponseType>{ *this, response, false });
+}
+
+template <typename ResponseType>
+auto ReplyAddress<ResponseType>::notify(const ResponseType& response) const -> void
+{
+    outbox->notify(Reply<ResponseType>{ *this, response, true });
+}
+
+// The ways a handler can take the messages UDSServer reads, resolved at
+// compile time so that dispatch can be inlined. The event loops use the
+// first of these a handler provides:
+//
+//     handle_async(address, messages)      hands a batch off, each message
+//                                          answered later through address,
+//                                          returns how many it took
+//     handle_batch(messages, responses)    answers a batch in place, false
+//                                          if there is nothing to send
+//     handle(message) -> response          answers one message
+//
+// on_recv(message), if present, sees every message first.
+template <typename Handler, typename MessageType, typename ResponseType>
+concept AsyncMessageHandler = requires(Handler& handler,
+                                       const ReplyAddress<ResponseType>& address,
+                                       std::span<const MessageType> messages)
+{
+    { handler.handle_async(address, messages) } -> std::same_as<std::size_t>;
+};
+
+template <typename Handler, typename MessageType, typename ResponseType>
+concept BatchMessageHandler = requires(Handler& handler,
+                                       std::span<const MessageType> messages,
+                                       std::span<ResponseType> responses)
+{
+    { handler.handle_batch(messages, responses) } -> std::same_as<bool>;
+};
+
+template <typename Handler, typename MessageType, typename ResponseType>
+concept SingleMessageHandler = requires(Handler& handler, const MessageType& message)
+{
+    { handler.handle(message) } -> std::convertible_to<ResponseType>;
+};
+
+template <typename Handler, typename MessageType>
+concept RecvObserver = requires(Handler& handler, const MessageType& message)
+{
+    handler.on_recv(message);
+};
+
+// Handler built from callbacks posted at runtime, for servers whose
+// handling is not known by type.
+template <typename MessageType, typename ResponseType>
+struct CallbackHandler
+{
+    std::function<void(const MessageType&)> recv_callback;
+    std::function<ResponseType(const MessageType&)> response_gen_callback;
+    std::function<void(std::span<const MessageType>, std::span<ResponseType>)> batch_callback;
+
+    auto on_recv(const MessageType& message) -> void
+    {
+        if (recv_callback)
+            recv_callback(message);
+    }
+
+    auto handle_batch(std::span<const MessageType> messages, std::span<ResponseType> responses) -> bool
+    {
+        if (batch_callback)
+            batch_callback(messages, responses);
+        else if (response_gen_callback)
+            for (auto i = std::size_t{0}; i < messages.size(); i++)
+                responses[i] = response_gen_callback(messages[i]);
+        else
+            return false;
+
+        return true;
+    }
+};
+
+}
@@ -6,28 +6,54 @@
 #include <sys/un.h>
 #include <unistd.h>
 #include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 // C++
-#include <iostream>
 #include <format>
 #include <expected>
 #include <string>
 #include <type_traits>
 #include <functional>
 #include <csignal>
+#include <array>
+#include <vector>
+#include <cstring>
+#include <unordered_map>
+#include <span>
+#include <memory>
+#include <thread>
+#include <algorithm>
 
 #include "socket_ops.hpp"
+#include "async_logger.hpp"
+#include "mpsc_queue.hpp"
+#include "codec.hpp"
+#include "message_handler.hpp"
+
+#ifdef EXCHANGE_IO_URING
+#include "io_uring.hpp"
+#endif
 
 namespace exchange
 {
 
-template <typename MessageType, typename ResponseType = MessageType>
+// Codec frames messages for the event loops, start_server() always sends
+// and receives raw objects. Handler takes the messages read, see
+// message_handler.hpp; by default it is built from posted callbacks.
+template <typename MessageType,
+          typename ResponseType = MessageType,
+          typename Codec = raw_codec,
+          typename Handler = CallbackHandler<MessageType, ResponseType>>
 requires std::is_trivial_v<MessageType> && 
             std::is_trivial_v<ResponseType>
 class UDSServer
 {
 public:
-    UDSServer()
+    using ReplyAddressType = ReplyAddress<ResponseType>;
+
+    explicit UDSServer(Handler handler = Handler{}):
+        m_handler(std::move(handler))
     {
         m_socket = socket(AF_UNIX, SOCK_STREAM, DEFAULT_PROTOCOL);
 
@@ -65,21 +91,35 @@ public:
 
     ~UDSServer()
     {
-        std::cout << "DTor.\n";
+        log_debug<"DTor.">();
         close(m_socket);
     }
 
     auto post_on_recv_callback(std::function<void(const MessageType&)> recv_callback)
+    requires std::same_as<Handler, CallbackHandler<MessageType, ResponseType>>
     {
-        m_recv_callback = recv_callback;
+        m_handler.recv_callback = recv_callback;
     }
 
     auto post_response_gen_callback(std::function<ResponseType(const MessageType&)> resp_callback)
+    requires std::same_as<Handler, CallbackHandler<MessageType, ResponseType>>
+    {
+        m_handler.response_gen_callback = resp_callback;
+    }
+
+    // Event loops only. Called once per wakeup with every complete message
+    // read from a connection, in order, and fills in one response per
+    // message. Takes precedence over the response gen callback.
+    auto post_batch_response_callback(std::function<void(std::span<const MessageType>, std::span<ResponseType>)> batch_callback)
+    requires std::same_as<Handler, CallbackHandler<MessageType, ResponseType>>
     {
-        m_response_gen_callback = resp_callback;
+        m_handler.batch_callback = batch_callback;
     }
 
-    auto start_server() const -> std::expected<void, SocketError>
+    // Serves one message per connection, so a handler has to answer it
+    // straight away.
+    auto start_server() -> std::expected<void, SocketError>
+    requires (!AsyncMessageHandler<Handler, MessageType, ResponseType>)
     {
         auto ret = std::expected<void, SocketError>{};
 
@@ -88,16 +128,718 @@ public:
         return std::unexpected(ret.error());
     }
 
+    // Serves many long lived connections from io_threads threads, each
+    // accepting its own share of them. Each wakeup handles every complete
+    // message buffered on a readable connection as a batch and queues the
+    // responses, which are flushed with one write as the socket allows. Runs
+    // on io_uring when built with EXCHANGE_IO_URING, epoll otherwise.
+    //
+    // The handler runs on the I/O threads, concurrently if there are several.
+    // Returns once stop is requested.
+    auto start_event_loop(unsigned io_threads = 1, std::stop_token stop = {}) -> std::expected<void, SocketError>
+    {
+        if (auto ret = set_non_blocking(m_socket))
+        {}
+        else
+            return ret;
+
+        m_loops.clear();
+
+        for (auto i = 0u; i < std::max(io_threads, 1u); i++)
+            m_loops.push_back(std::make_unique<Loop>(i));
+
+        auto helpers = std::vector<std::jthread>{};
+
+        for (auto i = 1u; i < m_loops.size(); i++)
+            helpers.emplace_back([this, &loop = *m_loops[i]](std::stop_token stop){
+                if (auto ret = run_loop(loop, stop))
+                {}
+                else
+                    log_error<"I/O thread {} stopped on error.">(loop.index);
+            });
+
+        auto wake_first = std::stop_callback{stop, [this]{ m_loops[0]->wake(); }};
+        auto ret = run_loop(*m_loops[0], stop);
+
+        for (auto& helper: helpers)
+            helper.request_stop();
+
+        for (auto i = 1u; i < m_loops.size(); i++)
+            m_loops[i]->wake();
+
+        return ret;
+    }
+
 private:
+    static constexpr int MAX_EVENTS = 256;
+    static constexpr std::size_t READ_BUFFER_SIZE = 64 * 1024;
+    // Bounds the requests an I/O thread has handed off and not yet seen
+    // answered, so a reply always finds room in its outbox.
+    static constexpr std::size_t OUTBOX_CAPACITY = 16 * 1024;
+    // Unsolicited messages, such as fill reports, queued on top of replies.
+    static constexpr std::size_t REPORT_CAPACITY = 16 * 1024;
+    static constexpr std::size_t MAX_ASYNC_BATCH = 1024;
+
+    struct Connection
+    {
+        std::vector<char> rx = std::vector<char>(READ_BUFFER_SIZE);
+        std::size_t rx_len = 0;
+        std::vector<char> tx;
+        std::size_t tx_sent = 0;
+        bool want_write = false;
+        bool closing = false;
+        uint64_t serial = 0;
+    };
+
+    // State owned by one I/O thread, apart from the outbox which any thread
+    // may reply through.
+    struct Loop
+    {
+        explicit Loop(uint32_t index):
+            index(index),
+            wake_fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+            outbox(OUTBOX_CAPACITY, REPORT_CAPACITY, wake_fd)
+        {
+            if (wake_fd == -1)
+                throw std::runtime_error(std::format("Unable to create eventfd. Errno: {}\n", errno));
+        }
+
+        Loop(const Loop& other) = delete;
+        Loop operator=(const Loop& other) = delete;
+
+        ~Loop()
+        {
+            close(wake_fd);
+        }
+
+        auto wake() const -> void
+        {
+            auto one = uint64_t{1};
+            [[maybe_unused]] auto ret = write(wake_fd, &one, sizeof(one));
+        }
+
+        auto clear_wake() const -> void
+        {
+            auto count = uint64_t{0};
+            [[maybe_unused]] auto ret = read(wake_fd, &count, sizeof(count));
+        }
+
+        uint32_t index;
+        int wake_fd;
+        Outbox<ResponseType> outbox;
+        std::size_t in_flight = 0;
+        uint64_t next_serial = 1;
+        std::vector<MessageType> batch;
+        std::vector<ResponseType> batch_responses;
+        // Connections with responses to flush or that are to be closed.
+        std::vector<int> dirty;
+    };
+
+    auto run_loop(Loop& loop, std::stop_token stop) -> std::expected<void, SocketError>
+    {
+#ifdef EXCHANGE_IO_URING
+        return run_uring_loop(loop, stop);
+#else
+        return run_epoll_loop(loop, stop);
+#endif
+    }
+
+    auto run_epoll_loop(Loop& loop, std::stop_token stop) -> std::expected<void, SocketError>
+    {
+        auto epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+        if (epoll_fd == -1 ||
+            !watch(epoll_fd, EPOLL_CTL_ADD, m_socket, EPOLLIN | EPOLLEXCLUSIVE) ||
+            !watch(epoll_fd, EPOLL_CTL_ADD, loop.wake_fd, EPOLLIN))
+        {
+            log_error<"Unable to set up epoll. Errno: {}">(errno);
+
+            if (epoll_fd != -1)
+                close(epoll_fd);
+
+            return std::unexpected(SocketError::PollFailed);
+        }
+
+        auto connections = std::unordered_map<int, Connection>{};
+        auto events = std::array<epoll_event, MAX_EVENTS>{};
+
+        while (!stop.stop_requested())
+        {
+            // Only sleep in the kernel when no replies are outstanding.
+            auto sleep = !loop.in_flight && loop.outbox.prepare_sleep();
+            auto count = epoll_wait(epoll_fd, events.data(), MAX_EVENTS, sleep ? -1 : 0);
+            loop.outbox.end_sleep();
+
+            if (count == -1)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                log_error<"epoll_wait failed. Errno: {}">(errno);
+                break;
+            }
+
+            for (auto& event: std::span{events.data(), std::size_t(count)})
+            {
+                if (event.data.fd == m_socket)
+                {
+                    accept_connections(epoll_fd, loop, connections);
+                    continue;
+                }
+
+                if (event.data.fd == loop.wake_fd)
+                {
+                    loop.clear_wake();
+                    continue;
+                }
+
+                auto it = connections.find(event.data.fd);
+
+                if (it == connections.end())
+                    continue;
+
+                auto& [fd, connection] = *it;
+
+                if (event.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+                    connection.closing = !read_messages(loop, connections, fd, connection);
+
+                loop.dirty.push_back(fd);
+            }
+
+            auto delivered = drain_outbox(loop, connections);
+
+            for (auto fd: loop.dirty)
+            {
+                auto it = connections.find(fd);
+
+                if (it == connections.end())
+                    continue;
+
+                if (!flush(epoll_fd, fd, it->second) || it->second.closing)
+                {
+                    close(fd);
+                    connections.erase(it);
+                }
+            }
+
+            loop.dirty.clear();
+
+            if (!count && !delivered)
+                std::this_thread::yield();
+        }
+
+        for (auto& [fd, connection]: connections)
+            close(fd);
+
+        close(epoll_fd);
+
+        if (stop.stop_requested())
+            return {};
+
+        return std::unexpected(SocketError::PollFailed);
+    }
+
+#ifdef EXCHANGE_IO_URING
+    static constexpr unsigned URING_ENTRIES = 1024;
+    static constexpr unsigned URING_BUFFER_COUNT = 1024;
+    static constexpr unsigned URING_BUFFER_SIZE = 4096;
+    static constexpr uint16_t URING_BUFFER_GROUP = 0;
+
+    enum class UringOp: uint64_t
+    {
+        ACCEPT,
+        RECV,
+        SEND,
+        PROVIDE,
+        WAKE
+    };
+
+    struct UringConnection: Connection
+    {
+        // Responses being written by an in flight SEND, new responses queue
+        // up in tx meanwhile.
+        std::vector<char> tx_in_flight;
+        std::size_t in_flight_sent = 0;
+        bool receiving = false;
+        bool sending = false;
+        bool send_failed = false;
+    };
+
+    static auto tag(UringOp op, int fd) -> uint64_t
+    {
+        return (static_cast<uint64_t>(op) << 32) | static_cast<uint32_t>(fd);
+    }
+
+    // Accepts and receives with multishot requests reading into kernel
+    // provided buffers, and writes each connection's queued responses with one
+    // SEND per wakeup. A burst of messages over many connections costs one
+    // io_uring_enter per loop rather than syscalls per message.
+    auto run_uring_loop(Loop& loop, std::stop_token stop) -> std::expected<void, SocketError>
+    {
+        auto ring = IoUring{URING_ENTRIES, URING_ENTRIES * 4};
+        auto buffers = ProvidedBuffers{ring,
+                                       URING_BUFFER_GROUP,
+                                       URING_BUFFER_COUNT,
+                                       URING_BUFFER_SIZE,
+                                       tag(UringOp::PROVIDE, 0)};
+        auto connections = std::unordered_map<int, UringConnection>{};
+
+        arm_accept(ring);
+        arm_wake(ring, loop);
+
+        while (!stop.stop_requested())
+        {
+            // Only sleep in the kernel when no replies are outstanding.
+            auto sleep = !loop.in_flight && loop.outbox.prepare_sleep();
+            auto submitted = ring.submit_and_wait(sleep ? 1 : 0);
+            loop.outbox.end_sleep();
+
+            if (submitted == -1)
+            {
+                log_error<"io_uring_enter failed. Errno: {}">(errno);
+                return std::unexpected(SocketError::PollFailed);
+            }
+
+            auto completions = ring.for_each_cqe([&](const io_uring_cqe& cqe){
+                auto op = static_cast<UringOp>(cqe.user_data >> 32);
+                auto fd = static_cast<int>(cqe.user_data & 0xffffffff);
+                auto more = cqe.flags & IORING_CQE_F_MORE;
+
+                if (op == UringOp::PROVIDE)
+                {
+                    log_error<"Unable to provide receive buffers. Errno: {}">(-cqe.res);
+                    return;
+                }
+
+                if (op == UringOp::WAKE)
+                {
+                    loop.clear_wake();
+                    arm_wake(ring, loop);
+                    return;
+                }
+
+                if (op == UringOp::ACCEPT)
+                {
+                    if (cqe.res >= 0)
+                    {
+                        auto& connection = connections[cqe.res];
+                        connection.serial = loop.next_serial++;
+                        connection.receiving = true;
+                        arm_recv(ring, cqe.res);
+                    }
+
+                    if (!more)
+                        arm_accept(ring);
+
+                    return;
+                }
+
+                auto it = connections.find(fd);
+
+                if (it == connections.end())
+                    return;
+
+                auto& connection = it->second;
+                loop.dirty.push_back(fd);
+
+                if (op == UringOp::RECV)
+                {
+                    if (cqe.res > 0)
+                    {
+                        auto id = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+                        auto received = std::span<const char>{buffers.data(id), std::size_t(cqe.res)};
+
+                        // Whatever arrives after a connection has been shut
+                        // down is dropped.
+                        if (!connection.send_failed && !take_received(loop, connections, fd, connection, received))
+                        {
+                            connection.send_failed = true;
+                            shutdown(fd, SHUT_RDWR);
+                        }
+
+                        buffers.recycle(id);
+                    }
+
+                    // Out of buffers just ends the multishot, anything else
+                    // without more to come means the peer is gone.
+                    if (!more)
+                    {
+                        if (cqe.res > 0 || cqe.res == -ENOBUFS)
+                            arm_recv(ring, fd);
+                        else
+                            connection.receiving = false;
+                    }
+                }
+                else
+                {
+                    if (cqe.res < 0)
+                    {
+                        connection.sending = false;
+                        connection.send_failed = true;
+                        shutdown(fd, SHUT_RDWR);
+                    }
+                    else
+                    {
+                        connection.in_flight_sent += cqe.res;
+
+                        if (connection.in_flight_sent < connection.tx_in_flight.size())
+                            prep_send(ring, fd, connection);
+                        else
+                            connection.sending = false;
+                    }
+                }
+            });
+
+            auto delivered = drain_outbox(loop, connections);
+
+            for (auto fd: loop.dirty)
+            {
+                auto it = connections.find(fd);
+
+                if (it == connections.end())
+                    continue;
+
+                auto& connection = it->second;
+
+                if (!connection.sending && !connection.send_failed && !connection.tx.empty())
+                {
+                    std::swap(connection.tx, connection.tx_in_flight);
+                    connection.tx.clear();
+                    connection.in_flight_sent = 0;
+                    connection.sending = true;
+                    prep_send(ring, fd, connection);
+                }
+
+                if (!connection.receiving && !connection.sending)
+                {
+                    close(fd);
+                    connections.erase(it);
+                }
+            }
+
+            loop.dirty.clear();
+
+            if (!completions && !delivered)
+                std::this_thread::yield();
+        }
+
+        // Closing the sockets ends their requests, the ring is torn down
+        // with whatever is left.
+        for (auto& [fd, connection]: connections)
+            close(fd);
+
+        return {};
+    }
+
+    // Appends a completed receive to the connection's buffer, handling
+    // messages whenever it fills as read_messages() does. Returns false if the
+    // peer sent a malformed frame or one that does not fit the buffer.
+    template <typename Connections>
+    auto take_received(Loop& loop,
+                       Connections& connections,
+                       int fd,
+                       Connection& connection,
+                       std::span<const char> received) -> bool
+    {
+        while (true)
+        {
+            auto n = std::min(connection.rx.size() - connection.rx_len, received.size());
+            std::memcpy(connection.rx.data() + connection.rx_len, received.data(), n);
+            connection.rx_len += n;
+            received = received.subspan(n);
+
+            if (!handle_messages(loop, connections, fd, connection))
+                return false;
+
+            if (received.empty())
+                return true;
+
+            if (connection.rx_len == connection.rx.size())
+                return false;
+        }
+    }
+
+    auto arm_accept(IoUring& ring) const -> void
+    {
+        auto sqe = ring.get_sqe();
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = m_socket;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_CLOEXEC;
+        sqe->user_data = tag(UringOp::ACCEPT, m_socket);
+    }
+
+    static auto arm_wake(IoUring& ring, const Loop& loop) -> void
+    {
+        auto sqe = ring.get_sqe();
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = loop.wake_fd;
+        sqe->poll32_events = POLLIN;
+        sqe->user_data = tag(UringOp::WAKE, loop.wake_fd);
+    }
+
+    static auto arm_recv(IoUring& ring, int fd) -> void
+    {
+        auto sqe = ring.get_sqe();
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = fd;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = URING_BUFFER_GROUP;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->user_data = tag(UringOp::RECV, fd);
+    }
+
+    static auto prep_send(IoUring& ring, int fd, UringConnection& connection) -> void
+    {
+        auto sqe = ring.get_sqe();
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(connection.tx_in_flight.data() + connection.in_flight_sent);
+        sqe->len = connection.tx_in_flight.size() - connection.in_flight_sent;
+        sqe->msg_flags = MSG_NOSIGNAL;
+        sqe->user_data = tag(UringOp::SEND, fd);
+    }
+#endif
+
+    static auto watch(int epoll_fd, int op, int fd, uint32_t events) -> bool
+    {
+        auto event = epoll_event{};
+        event.events = events;
+        event.data.fd = fd;
+
+        return epoll_ctl(epoll_fd, op, fd, &event) != -1;
+    }
+
+    auto accept_connections(int epoll_fd, Loop& loop, std::unordered_map<int, Connection>& connections) const -> void
+    {
+        while (true)
+        {
+            auto fd = accept4(m_socket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+            if (fd == -1)
+            {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                    log_warn<"Unable to accept on socket. Errno: {}">(errno);
+
+                if (errno == EINTR)
+                    continue;
+
+                return;
+            }
+
+            if (!watch(epoll_fd, EPOLL_CTL_ADD, fd, EPOLLIN | EPOLLRDHUP))
+            {
+                close(fd);
+                continue;
+            }
+
+            connections.try_emplace(fd).first->second.serial = loop.next_serial++;
+        }
+    }
+
+    // Drains the socket and handles every complete message in the buffer.
+    // Returns false once the peer has gone away.
+    template <typename Connections>
+    auto read_messages(Loop& loop, Connections& connections, int fd, Connection& connection) -> bool
+    {
+        auto open = true;
+
+        while (true)
+        {
+            auto free = connection.rx.size() - connection.rx_len;
+            auto n = recv(fd, connection.rx.data() + connection.rx_len, free, 0);
+
+            if (n > 0)
+            {
+                connection.rx_len += n;
+
+                if (connection.rx_len == connection.rx.size() &&
+                    !handle_messages(loop, connections, fd, connection))
+                    return false;
+
+                continue;
+            }
+
+            if (n == -1 && errno == EINTR)
+                continue;
+
+            if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+                open = false;
+
+            break;
+        }
+
+        return handle_messages(loop, connections, fd, connection) && open;
+    }
+
+    // Decodes every complete frame in the receive buffer and hands them to
+    // the callbacks as one batch, queueing any responses given back straight
+    // away. Returns false if the peer sent a malformed frame.
+    template <typename Connections>
+    auto handle_messages(Loop& loop, Connections& connections, int fd, Connection& connection) -> bool
+    {
+        auto buffered = std::as_bytes(std::span{connection.rx.data(), connection.rx_len});
+        auto offset = std::size_t{0};
+
+        loop.batch.clear();
+
+        while (auto size = Codec::template frame_size<MessageType>(buffered.subspan(offset)))
+        {
+            if (!Codec::template decode<MessageType>(buffered.subspan(offset, size), loop.batch.emplace_back()))
+                return false;
+
+            offset += size;
+        }
+
+        connection.rx_len -= offset;
+        std::memmove(connection.rx.data(), connection.rx.data() + offset, connection.rx_len);
+
+        if (loop.batch.empty())
+            return true;
+
+        if constexpr (RecvObserver<Handler, MessageType>)
+            for (const auto& message: loop.batch)
+                m_handler.on_recv(message);
+
+        if constexpr (AsyncMessageHandler<Handler, MessageType, ResponseType>)
+        {
+            auto address = ReplyAddressType{ &loop.outbox, fd, connection.serial };
+            auto pending = std::span<const MessageType>{loop.batch};
+
+            while (!pending.empty())
+            {
+                auto chunk = pending.first(std::min(pending.size(), MAX_ASYNC_BATCH));
+
+                while (loop.in_flight + chunk.size() > OUTBOX_CAPACITY)
+                    if (!drain_outbox(loop, connections))
+                        std::this_thread::yield();
+
+                // What the handler has no room for yet is offered again once
+                // the outbox has been drained, which may be what it waits on.
+                auto taken = m_handler.handle_async(address, chunk);
+                loop.in_flight += taken;
+                pending = pending.subspan(taken);
+
+                if (taken < chunk.size() && !drain_outbox(loop, connections))
+                    std::this_thread::yield();
+            }
+
+            return true;
+        }
+        else if constexpr (BatchMessageHandler<Handler, MessageType, ResponseType>)
+        {
+            loop.batch_responses.resize(loop.batch.size());
+
+            if (!m_handler.handle_batch(loop.batch, loop.batch_responses))
+                return true;
+        }
+        else
+        {
+            static_assert(SingleMessageHandler<Handler, MessageType, ResponseType>,
+                          "Handler does not provide a way to take messages.");
+
+            loop.batch_responses.clear();
+
+            for (const auto& message: loop.batch)
+                loop.batch_responses.push_back(m_handler.handle(message));
+        }
+
+        for (const auto& response: loop.batch_responses)
+            queue_response(connection, response);
+
+        return true;
+    }
+
+    // Moves replies from the outbox onto their connections' send buffers,
+    // dropping any for connections that have since closed. Returns the
+    // number taken.
+    template <typename Connections>
+    auto drain_outbox(Loop& loop, Connections& connections) -> std::size_t
+    {
+        auto reply = Reply<ResponseType>{};
+        auto count = std::size_t{0};
+        auto answered = std::size_t{0};
+
+        while (loop.outbox.try_pop(reply))
+        {
+            count++;
+            answered += !reply.unsolicited;
+
+            auto it = connections.find(reply.address.fd);
+
+            if (it == connections.end() || it->second.serial != reply.address.serial)
+                continue;
+
+            queue_response(it->second, reply.response);
+            loop.dirty.push_back(reply.address.fd);
+        }
+
+        loop.in_flight -= answered;
+
+        return count;
+    }
+
+    static auto queue_response(Connection& connection, const ResponseType& response) -> void
+    {
+        auto end = connection.tx.size();
+        connection.tx.resize(end + Codec::template max_frame_size<ResponseType>);
+        auto out = reinterpret_cast<std::byte*>(connection.tx.data() + end);
+        connection.tx.resize(end + Codec::template encode<ResponseType>(response, out));
+    }
+
+    // Writes out queued responses, asking for EPOLLOUT while the socket is
+    // full. Returns false if the connection failed.
+    auto flush(int epoll_fd, int fd, Connection& connection) const -> bool
+    {
+        while (connection.tx_sent < connection.tx.size())
+        {
+            auto n = send(fd,
+                          connection.tx.data() + connection.tx_sent,
+                          connection.tx.size() - connection.tx_sent,
+                          MSG_NOSIGNAL);
+
+            if (n >= 0)
+            {
+                connection.tx_sent += n;
+                continue;
+            }
+
+            if (errno == EINTR)
+                continue;
+
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                return false;
+
+            if (!connection.want_write)
+            {
+                connection.want_write = true;
+                return watch(epoll_fd, EPOLL_CTL_MOD, fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP);
+            }
+
+            return true;
+        }
+
+        connection.tx.clear();
+        connection.tx_sent = 0;
+
+        if (connection.want_write)
+        {
+            connection.want_write = false;
+            return watch(epoll_fd, EPOLL_CTL_MOD, fd, EPOLLIN | EPOLLRDHUP);
+        }
+
+        return true;
+    }
+
     static constexpr int MAX_QUEUE_LEN = 128;
     const char *SOCKET_PATH = "foobar";
     static constexpr int DEFAULT_PROTOCOL = 0;
 
     int m_socket;
-    std::function<void(const MessageType&)> m_recv_callback;
-    std::function<ResponseType(const MessageType&)> m_response_gen_callback;
+    Handler m_handler;
+    std::vector<std::unique_ptr<Loop>> m_loops;
 
-    auto wait_msg() const -> std::expected<void, SocketError>
+    auto wait_msg() -> std::expected<void, SocketError>
     {
         auto incoming_socket{-1};
 
@@ -116,15 +858,15 @@ private:
             return ret;
         
 
-        if (m_recv_callback)
-            m_recv_callback(received_object);
+        if constexpr (RecvObserver<Handler, MessageType>)
+            m_handler.on_recv(received_object);
 
         close(incoming_socket);
 
         return {};
     }
 
-    auto wait_msg_and_respond() const -> std::expected<void, SocketError>
+    auto wait_msg_and_respond() -> std::expected<void, SocketError>
     {
         auto incoming_socket{-1};
 
@@ -142,10 +884,15 @@ private:
         else
             return ret;
 
+        if constexpr (RecvObserver<Handler, MessageType>)
+            m_handler.on_recv(received_object);
+
         auto response = ResponseType{};
 
-        if (m_response_gen_callback)
-            response = m_response_gen_callback(received_object);
+        if constexpr (SingleMessageHandler<Handler, MessageType, ResponseType>)
+            response = m_handler.handle(received_object);
+        else
+            m_handler.handle_batch(std::span{&received_object, 1}, std::span{&response, 1});
 
         if (auto ret = do_send(incoming_socket, response))
         {}
@@ -0,0 +1,149 @@
+#pragma once
+
+// C
+#include <sys/socket.h>
+#include <errno.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// C++
+#include <expected>
+#include <span>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+#include "socket_ops.hpp"
+#include "async_logger.hpp"
+#include "codec.hpp"
+
+namespace exchange
+{
+
+// Long lived connection to a UDSServer running its event loop. Unlike
+// UDSClient it connects once and lets any number of messages be written
+// before their responses are read back, in order.
+template <typename MessageType, typename ResponseType = MessageType, typename Codec = raw_codec>
+requires std::is_trivial_v<MessageType> &&
+            std::is_trivial_v<ResponseType>
+class UDSSession
+{
+public:
+    UDSSession() = default;
+
+    UDSSession(const UDSSession& other) = delete;
+    UDSSession operator=(const UDSSession& other) = delete;
+
+    UDSSession(UDSSession&& other) = delete;
+    UDSSession operator=(UDSSession&& other) = delete;
+
+    ~UDSSession()
+    {
+        disconnect();
+    }
+
+    auto connected() const -> bool
+    {
+        return m_socket != -1;
+    }
+
+    auto connect() -> std::expected<void, SocketError>
+    {
+        if (connected())
+            return {};
+
+        if ((m_socket = socket(AF_UNIX, SOCK_STREAM, DEFAULT_PROTOCOL)) == -1)
+        {
+            log_warn<"Failed to open socket {}">(errno);
+            return std::unexpected(SocketError::ConnectFailed);
+        }
+
+        if (auto ret = do_connect(m_socket, SOCKET_PATH))
+            return {};
+        else
+        {
+            disconnect();
+            return ret;
+        }
+    }
+
+    auto disconnect() -> void
+    {
+        if (connected())
+            close(m_socket);
+
+        m_socket = -1;
+        m_rx.clear();
+    }
+
+    auto send_msg(const MessageType& data) -> std::expected<void, SocketError>
+    {
+        return send_batch(std::span{&data, 1});
+    }
+
+    // Writes all messages with as few syscalls as the socket allows.
+    auto send_batch(std::span<const MessageType> data) -> std::expected<void, SocketError>
+    {
+        if (auto ret = connect())
+        {}
+        else
+            return ret;
+
+        m_tx.resize(data.size() * Codec::template max_frame_size<MessageType>);
+        auto encoded = std::size_t{0};
+
+        for (const auto& message : data)
+            encoded += Codec::template encode<MessageType>(message, m_tx.data() + encoded);
+
+        if (auto ret = send_all(m_socket, std::span{m_tx}.first(encoded)))
+            return {};
+        else
+        {
+            disconnect();
+            return ret;
+        }
+    }
+
+    // Blocks until the next response has been read in full.
+    auto recv_msg() -> std::expected<ResponseType, SocketError>
+    {
+        auto size = std::size_t{0};
+
+        while (connected() && !(size = Codec::template frame_size<ResponseType>(m_rx)))
+        {
+            auto buffered = m_rx.size();
+            m_rx.resize(buffered + RECV_CHUNK);
+            auto n = recv(m_socket, m_rx.data() + buffered, RECV_CHUNK, 0);
+            m_rx.resize(buffered + std::max<ssize_t>(n, 0));
+
+            if (n > 0 || (n == -1 && errno == EINTR))
+                continue;
+
+            log_warn<"Unable to read socket. Errno: {}">(errno);
+            disconnect();
+        }
+
+        auto response = ResponseType{};
+
+        if (!size || !Codec::template decode<ResponseType>(std::span{m_rx}.first(size), response))
+        {
+            disconnect();
+            return std::unexpected(SocketError::RecvFailed);
+        }
+
+        m_rx.erase(m_rx.begin(), m_rx.begin() + size);
+
+        return {response};
+    }
+
+private:
+    const char *SOCKET_PATH = "foobar";
+    static constexpr int DEFAULT_PROTOCOL = 0;
+    static constexpr std::size_t RECV_CHUNK = 4096;
+
+    int m_socket = -1;
+    std::vector<std::byte> m_tx;
+    std::vector<std::byte> m_rx;
+};
+
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+// C
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// C++
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace exchange
+{
+
+enum class ShmWaitPolicy
+{
+    BusyPoll,
+    Futex
+};
+
+// Process shared futex on a 32 bit word, the std::atomic wait/notify
+// implementation uses private futexes which do not work across processes.
+inline auto futex_wait(std::atomic<uint32_t>& word, uint32_t expected) -> void
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, nullptr, nullptr, 0);
+}
+
+inline auto futex_wake(std::atomic<uint32_t>& word) -> void
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+// Lets an idle consumer sleep on a futex until a producer rings it. Zero
+// filled memory is a valid doorbell.
+struct ShmDoorbell
+{
+    std::atomic<uint32_t> counter;
+    std::atomic<uint32_t> waiters;
+
+    // Producer side, after one or more pushes.
+    auto ring() -> void
+    {
+        counter.fetch_add(1);
+
+        if (waiters.load())
+            futex_wake(counter);
+    }
+
+    // Consumer side, sleeps while is_idle() holds and nobody has rung.
+    template <typename Predicate>
+    auto wait(Predicate is_idle) -> void
+    {
+        auto seen = counter.load();
+
+        if (!is_idle())
+            return;
+
+        waiters.fetch_add(1);
+
+        if (is_idle())
+            futex_wait(counter, seen);
+
+        waiters.fetch_sub(1);
+    }
+};
+
+// Single producer, single consumer ring laid out to live in a shared memory
+// mapping: no pointers, and a zero filled mapping is an empty ring.
+template <typename T, std::size_t Capacity>
+requires std::is_trivially_copyable_v<T> && ((Capacity & (Capacity - 1)) == 0)
+struct ShmRing
+{
+    static constexpr std::size_t CACHE_LINE = 64;
+
+    alignas(CACHE_LINE) std::atomic<uint64_t> head;
+    alignas(CACHE_LINE) std::atomic<uint64_t> tail;
+    alignas(CACHE_LINE) T slots[Capacity];
+
+    auto reset() -> void
+    {
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+
+    auto empty() const -> bool
+    {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    // Producer side.
+    auto full() const -> bool
+    {
+        return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire) == Capacity;
+    }
+
+    auto try_push(const T& value) -> bool
+    {
+        auto t = tail.load(std::memory_order_relaxed);
+
+        if (t - head.load(std::memory_order_acquire) == Capacity)
+            return false;
+
+        slots[t & (Capacity - 1)] = value;
+        tail.store(t + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    auto try_pop(T& value) -> bool
+    {
+        auto h = head.load(std::memory_order_relaxed);
+
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+
+        value = slots[h & (Capacity - 1)];
+        head.store(h + 1, std::memory_order_release);
+
+        return true;
+    }
+};
+
+}
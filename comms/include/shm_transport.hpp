@@ -0,0 +1,415 @@
+#pragma once
+
+// C
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+// C++
+#include <atomic>
+#include <expected>
+#include <format>
+#include <functional>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+
+#include "socket_ops.hpp"
+#include "async_logger.hpp"
+#include "shm_ring.hpp"
+
+namespace exchange
+{
+
+// Shared memory layout used by ShmServer and ShmClient: a fixed number of
+// client slots, each a request ring, a response ring and a doorbell for the
+// client to sleep on. Clients ring the region wide doorbell after posting
+// requests so an idle server can sleep on a single futex.
+//
+// A client claims a FREE slot and makes it ACTIVE, and hands it back as
+// DRAINING. Only the server empties the rings of a DRAINING slot and frees
+// it, so a slot is never reset while the server may still be serving it.
+template <typename MessageType, typename ResponseType>
+struct ShmRegion
+{
+    static constexpr uint32_t MAGIC = 0x6d6b7431;
+    static constexpr std::size_t MAX_CLIENTS = 64;
+    static constexpr std::size_t RING_CAPACITY = 1024;
+
+    enum SlotState: uint32_t
+    {
+        FREE,
+        CLAIMED,
+        ACTIVE,
+        DRAINING
+    };
+
+    struct Slot
+    {
+        std::atomic<uint32_t> state;
+        // Process that claimed the slot, so the server can tell when it is
+        // gone without disconnecting.
+        std::atomic<pid_t> owner;
+        ShmRing<MessageType, RING_CAPACITY> requests;
+        ShmRing<ResponseType, RING_CAPACITY> responses;
+        ShmDoorbell response_bell;
+    };
+
+    std::atomic<uint32_t> magic;
+    ShmDoorbell request_bell;
+    Slot slots[MAX_CLIENTS];
+};
+
+// Maps the named shared memory object, creating and sizing it if asked to.
+inline auto map_shm(const char* name, std::size_t size, bool create) -> void*
+{
+    auto flags = create ? O_CREAT | O_RDWR : O_RDWR;
+    auto fd = shm_open(name, flags, 0600);
+
+    if (fd == -1)
+        return nullptr;
+
+    if (create && ftruncate(fd, size) == -1)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    auto addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    return addr == MAP_FAILED ? nullptr : addr;
+}
+
+// Drop-in alternative to UDSServer for co-located clients. Requests are
+// taken from every active client slot in turn and their responses written
+// back to the same slot, with no syscalls unless the server goes idle under
+// ShmWaitPolicy::Futex. A slot is only read while its responses have room,
+// so a client that stops reading holds up nobody but itself, and a slot
+// left full by a client that has exited is freed.
+template <typename MessageType, typename ResponseType = MessageType>
+requires std::is_trivially_copyable_v<MessageType> &&
+            std::is_trivially_copyable_v<ResponseType>
+class ShmServer
+{
+public:
+    using RegionType = ShmRegion<MessageType, ResponseType>;
+
+    explicit ShmServer(ShmWaitPolicy policy = ShmWaitPolicy::Futex):
+        m_policy(policy)
+    {
+        shm_unlink(SHM_NAME);
+
+        auto addr = map_shm(SHM_NAME, sizeof(RegionType), true);
+
+        if (!addr)
+            throw std::runtime_error(std::format("Unable to map shared memory. Errno: {}\n", errno));
+
+        m_region = new (addr) RegionType{};
+        m_region->magic.store(RegionType::MAGIC, std::memory_order_release);
+    }
+
+    ShmServer(const ShmServer& other) = delete;
+    ShmServer operator=(const ShmServer& other) = delete;
+
+    ShmServer(ShmServer&& other) = delete;
+    ShmServer operator=(ShmServer&& other) = delete;
+
+    ~ShmServer()
+    {
+        munmap(m_region, sizeof(RegionType));
+        shm_unlink(SHM_NAME);
+    }
+
+    auto post_response_gen_callback(std::function<ResponseType(const MessageType&)> resp_callback)
+    {
+        m_response_gen_callback = resp_callback;
+    }
+
+    // Returns once stop is requested.
+    auto start_server(std::stop_token stop = {}) -> std::expected<void, SocketError>
+    {
+        auto idle = 0;
+        auto wake = std::stop_callback{stop, [this]{ m_region->request_bell.ring(); }};
+
+        while (!stop.stop_requested())
+        {
+            if (serve_once())
+            {
+                idle = 0;
+                continue;
+            }
+
+            if (++idle < IDLE_SPIN_LIMIT)
+                continue;
+
+            if (idle == IDLE_SPIN_LIMIT)
+                reclaim_abandoned_slots();
+
+            if (m_policy == ShmWaitPolicy::Futex)
+                m_region->request_bell.wait([&]{ return !pending() && !stop.stop_requested(); });
+            else
+                std::this_thread::yield();
+        }
+
+        return {};
+    }
+
+    // Same entry point name as UDSServer so callers can switch transports.
+    auto start_event_loop(std::stop_token stop = {}) -> std::expected<void, SocketError>
+    {
+        return start_server(stop);
+    }
+
+private:
+    static constexpr const char* SHM_NAME = "/minimarket";
+    static constexpr int IDLE_SPIN_LIMIT = 1024;
+
+    RegionType* m_region;
+    ShmWaitPolicy m_policy;
+    std::function<ResponseType(const MessageType&)> m_response_gen_callback;
+
+    // Requests that can be answered now. Clients ring the request bell as
+    // they free room for responses, so the server may sleep on the others.
+    auto pending() const -> bool
+    {
+        for (auto& slot: m_region->slots)
+        {
+            auto state = slot.state.load(std::memory_order_acquire);
+
+            if (state == RegionType::DRAINING ||
+                (state == RegionType::ACTIVE && !slot.requests.empty() && !slot.responses.full()))
+                return true;
+        }
+
+        return false;
+    }
+
+    static auto release(typename RegionType::Slot& slot) -> void
+    {
+        slot.requests.reset();
+        slot.responses.reset();
+        slot.state.store(RegionType::FREE, std::memory_order_release);
+    }
+
+    // Frees the slots left full by clients that exited without
+    // disconnecting. Only run as the server goes idle, as it costs a syscall
+    // per such slot.
+    auto reclaim_abandoned_slots() -> void
+    {
+        for (auto& slot: m_region->slots)
+        {
+            if (slot.state.load(std::memory_order_acquire) != RegionType::ACTIVE || !slot.responses.full())
+                continue;
+
+            auto owner = slot.owner.load(std::memory_order_relaxed);
+
+            if (kill(owner, 0) == -1 && errno == ESRCH)
+            {
+                log_warn<"Freeing the shared memory slot of exited client {}.">(owner);
+                release(slot);
+            }
+        }
+    }
+
+    // Serves every active slot once, up to the room left for its responses,
+    // and frees the slots clients have handed back. Returns whether any
+    // request was served.
+    auto serve_once() -> bool
+    {
+        auto served = false;
+        auto request = MessageType{};
+
+        for (auto& slot: m_region->slots)
+        {
+            auto state = slot.state.load(std::memory_order_acquire);
+
+            if (state == RegionType::DRAINING)
+                release(slot);
+
+            if (state != RegionType::ACTIVE)
+                continue;
+
+            auto answered = false;
+
+            while (!slot.responses.full() && slot.requests.try_pop(request))
+            {
+                auto response = m_response_gen_callback ?
+                                    m_response_gen_callback(request) :
+                                    ResponseType{};
+
+                slot.responses.try_push(response);
+                answered = true;
+            }
+
+            if (answered)
+            {
+                slot.response_bell.ring();
+                served = true;
+            }
+        }
+
+        return served;
+    }
+};
+
+// Client for ShmServer with the same session interface as UDSSession:
+// connect once, then send and receive messages in order.
+template <typename MessageType, typename ResponseType = MessageType>
+requires std::is_trivially_copyable_v<MessageType> &&
+            std::is_trivially_copyable_v<ResponseType>
+class ShmClient
+{
+public:
+    using RegionType = ShmRegion<MessageType, ResponseType>;
+
+    explicit ShmClient(ShmWaitPolicy policy = ShmWaitPolicy::Futex):
+        m_policy(policy)
+    {}
+
+    ShmClient(const ShmClient& other) = delete;
+    ShmClient operator=(const ShmClient& other) = delete;
+
+    ShmClient(ShmClient&& other) = delete;
+    ShmClient operator=(ShmClient&& other) = delete;
+
+    ~ShmClient()
+    {
+        disconnect();
+    }
+
+    auto connected() const -> bool
+    {
+        return m_slot != nullptr;
+    }
+
+    auto connect() -> std::expected<void, SocketError>
+    {
+        if (connected())
+            return {};
+
+        auto addr = map_shm(SHM_NAME, sizeof(RegionType), false);
+
+        if (!addr)
+        {
+            log_error<"Failed to map shared memory. {}">(errno);
+            return std::unexpected(SocketError::ConnectFailed);
+        }
+
+        m_region = static_cast<RegionType*>(addr);
+
+        if (m_region->magic.load(std::memory_order_acquire) != RegionType::MAGIC)
+        {
+            disconnect();
+            return std::unexpected(SocketError::ConnectFailed);
+        }
+
+        for (auto& slot: m_region->slots)
+        {
+            auto expected = uint32_t{RegionType::FREE};
+
+            if (slot.state.compare_exchange_strong(expected, RegionType::CLAIMED))
+            {
+                slot.owner.store(getpid(), std::memory_order_relaxed);
+                slot.state.store(RegionType::ACTIVE, std::memory_order_release);
+                m_slot = &slot;
+                return {};
+            }
+        }
+
+        log_warn<"No free shared memory client slots.">();
+        disconnect();
+        return std::unexpected(SocketError::ConnectFailed);
+    }
+
+    auto disconnect() -> void
+    {
+        // The server frees the slot once it is done with it.
+        if (m_slot)
+        {
+            m_slot->state.store(RegionType::DRAINING, std::memory_order_release);
+            m_region->request_bell.ring();
+        }
+
+        if (m_region)
+            munmap(m_region, sizeof(RegionType));
+
+        m_slot = nullptr;
+        m_region = nullptr;
+    }
+
+    auto send_msg(const MessageType& data) -> std::expected<void, SocketError>
+    {
+        return send_batch(std::span{&data, 1});
+    }
+
+    auto send_batch(std::span<const MessageType> data) -> std::expected<void, SocketError>
+    {
+        if (auto ret = connect())
+        {}
+        else
+            return ret;
+
+        for (auto& message: data)
+        {
+            // The server may be asleep on what has been pushed so far.
+            while (!m_slot->requests.try_push(message))
+            {
+                m_region->request_bell.ring();
+                std::this_thread::yield();
+            }
+        }
+
+        m_region->request_bell.ring();
+
+        return {};
+    }
+
+    auto recv_msg() -> std::expected<ResponseType, SocketError>
+    {
+        if (!connected())
+            return std::unexpected(SocketError::RecvFailed);
+
+        auto response = ResponseType{};
+
+        for (auto spins = 0; !m_slot->responses.try_pop(response); spins++)
+        {
+            if (spins < IDLE_SPIN_LIMIT)
+                continue;
+
+            if (m_policy == ShmWaitPolicy::Futex)
+                m_slot->response_bell.wait([&]{ return m_slot->responses.empty(); });
+            else
+                std::this_thread::yield();
+        }
+
+        // The server skips this slot while its responses are full.
+        if (!m_slot->requests.empty())
+            m_region->request_bell.ring();
+
+        return {response};
+    }
+
+    auto send_msg_and_get_response(const MessageType& data) -> std::expected<ResponseType, SocketError>
+    {
+        if (auto ret = send_msg(data))
+            return recv_msg();
+        else
+            return std::unexpected(ret.error());
+    }
+
+private:
+    static constexpr const char* SHM_NAME = "/minimarket";
+    static constexpr int IDLE_SPIN_LIMIT = 1024;
+
+    ShmWaitPolicy m_policy;
+    RegionType* m_region = nullptr;
+    typename RegionType::Slot* m_slot = nullptr;
+};
+
+}
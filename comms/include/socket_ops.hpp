@@ -1,6 +1,17 @@
 #pragma once
 
+// C
 #include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+
+// C++
+#include <cstddef>
+#include <cstring>
+#include <expected>
+#include <span>
+
+#include "async_logger.hpp"
 
 namespace exchange
 {
@@ -9,9 +20,23 @@ namespace exchange
         AcceptFailed,
         RecvFailed,
         ConnectFailed,
-        SendFailed
+        SendFailed,
+        PollFailed
     };
 
+    auto set_non_blocking(int socket) -> std::expected<void, SocketError>
+    {
+        auto flags = fcntl(socket, F_GETFL, 0);
+
+        if (flags == -1 || fcntl(socket, F_SETFL, flags | O_NONBLOCK) == -1)
+        {
+            log_warn<"Unable to make socket non-blocking. Errno: {}">(errno);
+            return std::unexpected(SocketError::PollFailed);
+        }
+
+        return {};
+    }
+
     auto do_connect(int socket,
                     const char *socket_path) -> std::expected<void, SocketError>
     {
@@ -22,7 +47,7 @@ namespace exchange
 
         if (connect(socket, (struct sockaddr *)&addr, sizeof(struct sockaddr_un)) == -1)
         {
-            std::cout << std::format("Failed to connect socket. {}\n", errno);
+            log_warn<"Failed to connect socket. {}">(errno);
             return std::unexpected(SocketError::ConnectFailed);
         }
 
@@ -38,7 +63,7 @@ namespace exchange
 
         if (sock == -1)
         {
-            std::cout << std::format("Unable to accept on socket. Errno: {}\n", errno);
+            log_warn<"Unable to accept on socket. Errno: {}">(errno);
             return std::unexpected{SocketError::AcceptFailed};
         }
         else
@@ -47,30 +72,66 @@ namespace exchange
         }
     }
 
-    template <typename ReceivedType>
-    auto do_recv(int socket,
-                     ReceivedType& received_object) -> std::expected<void, SocketError>
+    // Keeps writing until all of bytes are sent, a stream socket may accept
+    // less than was asked for.
+    auto send_all(int socket,
+                  std::span<const std::byte> bytes) -> std::expected<void, SocketError>
     {
-        if (recv(socket, &received_object, sizeof(ReceivedType), 0) == -1)
+        while (!bytes.empty())
         {
-            std::cout << std::format("Unable to read socket. Errno: {}\n", errno);
-            return std::unexpected{SocketError::RecvFailed};
+            auto n = send(socket, bytes.data(), bytes.size(), MSG_NOSIGNAL);
+
+            if (n == -1)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                log_warn<"Failed to write to socket {}">(errno);
+                return std::unexpected(SocketError::SendFailed);
+            }
+
+            bytes = bytes.subspan(n);
         }
 
         return {};
     }
 
-    template <typename SentType>
-    auto do_send(int socket,
-                     const SentType& sent_object) -> std::expected<void, SocketError>
+    // Reads exactly bytes.size() bytes, failing if the peer closes first.
+    auto recv_all(int socket,
+                  std::span<std::byte> bytes) -> std::expected<void, SocketError>
     {
-        if (send(socket, reinterpret_cast<const char*>(&sent_object), sizeof(SentType), 0) == -1)
+        while (!bytes.empty())
         {
-            std::cout << std::format("Failed to write to socket {}\n", errno);
-            return std::unexpected(SocketError::SendFailed);
+            auto n = recv(socket, bytes.data(), bytes.size(), MSG_WAITALL);
+
+            if (n > 0)
+            {
+                bytes = bytes.subspan(n);
+                continue;
+            }
+
+            if (n == -1 && errno == EINTR)
+                continue;
+
+            log_warn<"Unable to read socket. Errno: {}">(errno);
+            return std::unexpected{SocketError::RecvFailed};
         }
 
         return {};
     }
+
+    template <typename ReceivedType>
+    auto do_recv(int socket,
+                     ReceivedType& received_object) -> std::expected<void, SocketError>
+    {
+        return recv_all(socket, std::as_writable_bytes(std::span{&received_object, 1}));
+    }
+
+    template <typename SentType>
+    auto do_send(int socket,
+                     const SentType& sent_object) -> std::expected<void, SocketError>
+    {
+        return send_all(socket, std::as_bytes(std::span{&sent_object, 1}));
+    }
 }
 
@@ -0,0 +1,28 @@
+#pragma once
+
+// C++
+#include <cstdlib>
+#include <string_view>
+
+namespace exchange
+{
+
+enum class Transport
+{
+    UDS,
+    SHM
+};
+
+// Transport selected by the EXCHANGE_TRANSPORT environment variable, "shm"
+// for the shared memory rings, anything else for Unix domain sockets.
+inline auto transport_from_env() -> Transport
+{
+    auto value = std::getenv("EXCHANGE_TRANSPORT");
+
+    if (value && std::string_view{value} == "shm")
+        return Transport::SHM;
+
+    return Transport::UDS;
+}
+
+}
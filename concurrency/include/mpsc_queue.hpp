@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace exchange
+{
+
+// Bounded lock-free queue for many producers and a single consumer. Each cell
+// carries a sequence number which tells producers and the consumer whether it
+// is free or published for the current lap of the ring, so a push or pop is
+// one CAS (producers) or none (consumer) plus a release store.
+template <typename T>
+requires std::is_trivially_copyable_v<T>
+class MPSCQueue
+{
+public:
+    explicit MPSCQueue(std::size_t capacity):
+        m_capacity(std::bit_ceil(capacity)),
+        m_mask(m_capacity - 1),
+        m_cells(std::make_unique<Cell[]>(m_capacity))
+    {
+        for (auto i = std::size_t{0}; i < m_capacity; i++)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    MPSCQueue(const MPSCQueue& other) = delete;
+    MPSCQueue operator=(const MPSCQueue& other) = delete;
+
+    auto try_push(const T& value) -> bool
+    {
+        auto pos = m_tail.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            auto& cell = m_cells[pos & m_mask];
+            auto sequence = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+
+            if (diff == 0)
+            {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.value = value;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = m_tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    auto try_pop(T& value) -> bool
+    {
+        auto& cell = m_cells[m_head & m_mask];
+
+        if (cell.sequence.load(std::memory_order_acquire) != m_head + 1)
+            return false;
+
+        value = cell.value;
+        cell.sequence.store(m_head + m_capacity, std::memory_order_release);
+        m_head++;
+
+        return true;
+    }
+
+    // Consumer only.
+    auto empty() const -> bool
+    {
+        return m_cells[m_head & m_mask].sequence.load(std::memory_order_acquire) != m_head + 1;
+    }
+
+    auto capacity() const -> std::size_t
+    {
+        return m_capacity;
+    }
+
+private:
+    static constexpr std::size_t CACHE_LINE = 64;
+
+    struct alignas(CACHE_LINE) Cell
+    {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::size_t m_capacity;
+    std::size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+    alignas(CACHE_LINE) std::atomic<std::size_t> m_tail{0};
+    alignas(CACHE_LINE) std::size_t m_head{0};
+};
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+// C
+#include <pthread.h>
+#include <sched.h>
+
+// C++
+#include <thread>
+
+namespace exchange
+{
+
+// Pins the calling thread to a single core, wrapping around the cores that
+// are available. Returns false if the affinity could not be set.
+inline auto pin_current_thread(unsigned core) -> bool
+{
+    auto cores = std::thread::hardware_concurrency();
+
+    if (cores)
+        core %= cores;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) == 0;
+}
+
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+// C++
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace exchange
+{
+
+// Fixed set of worker threads for batches of independent tasks. Each worker
+// is dealt a share of a batch and works through it from the back of its own
+// deque. Once that runs dry it steals from the front of the others', so
+// uneven tasks still keep every worker busy until the batch is done.
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(unsigned threads = std::thread::hardware_concurrency())
+    {
+        if (!threads)
+            threads = 1;
+
+        for (auto i = 0u; i < threads; i++)
+            m_workers.push_back(std::make_unique<Worker>());
+
+        for (auto i = 0u; i < threads; i++)
+            m_workers[i]->thread = std::jthread{[this, i](std::stop_token stop){ work(stop, i); }};
+    }
+
+    WorkStealingPool(const WorkStealingPool& other) = delete;
+    WorkStealingPool operator=(const WorkStealingPool& other) = delete;
+
+    WorkStealingPool(WorkStealingPool&& other) = delete;
+    WorkStealingPool operator=(WorkStealingPool&& other) = delete;
+
+    ~WorkStealingPool()
+    {
+        {
+            auto lock = std::lock_guard{m_mutex};
+
+            for (auto& worker: m_workers)
+                worker->thread.request_stop();
+        }
+
+        m_batch_ready.notify_all();
+
+        for (auto& worker: m_workers)
+            worker->thread.join();
+    }
+
+    auto thread_count() const -> std::size_t
+    {
+        return m_workers.size();
+    }
+
+    // Runs task(i) for every i in [0, count) and waits for them all. The
+    // first exception thrown by a task is rethrown here once the rest of the
+    // batch has finished.
+    auto run(std::size_t count, std::function<void(std::size_t)> task) -> void
+    {
+        if (!count)
+            return;
+
+        auto lock = std::unique_lock{m_mutex};
+        m_task = std::move(task);
+        m_remaining = count;
+        m_error = nullptr;
+
+        for (auto i = std::size_t{0}; i < count; i++)
+        {
+            auto& worker = *m_workers[i % m_workers.size()];
+            auto worker_lock = std::lock_guard{worker.mutex};
+            worker.tasks.push_back(i);
+        }
+
+        m_batch++;
+        m_batch_ready.notify_all();
+        m_batch_done.wait(lock, [this]{ return !m_remaining; });
+
+        m_task = nullptr;
+
+        if (m_error)
+            std::rethrow_exception(m_error);
+    }
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<std::size_t> tasks;
+        std::jthread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_batch_ready;
+    std::condition_variable m_batch_done;
+    std::function<void(std::size_t)> m_task;
+    std::size_t m_remaining = 0;
+    std::size_t m_batch = 0;
+    std::exception_ptr m_error;
+
+    auto work(std::stop_token stop, std::size_t self) -> void
+    {
+        auto seen = std::size_t{0};
+
+        while (true)
+        {
+            {
+                auto lock = std::unique_lock{m_mutex};
+                m_batch_ready.wait(lock, [&]{ return stop.stop_requested() || m_batch != seen; });
+
+                if (stop.stop_requested())
+                    return;
+
+                seen = m_batch;
+            }
+
+            while (auto index = next_task(self))
+            {
+                auto error = std::exception_ptr{};
+
+                try
+                {
+                    m_task(*index);
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+
+                auto lock = std::lock_guard{m_mutex};
+
+                if (error && !m_error)
+                    m_error = error;
+
+                if (!--m_remaining)
+                    m_batch_done.notify_all();
+            }
+        }
+    }
+
+    auto next_task(std::size_t self) -> std::optional<std::size_t>
+    {
+        {
+            auto& own = *m_workers[self];
+            auto lock = std::lock_guard{own.mutex};
+
+            if (!own.tasks.empty())
+            {
+                auto index = own.tasks.back();
+                own.tasks.pop_back();
+                return index;
+            }
+        }
+
+        for (auto offset = std::size_t{1}; offset < m_workers.size(); offset++)
+        {
+            auto& victim = *m_workers[(self + offset) % m_workers.size()];
+            auto lock = std::lock_guard{victim.mutex};
+
+            if (!victim.tasks.empty())
+            {
+                auto index = victim.tasks.front();
+                victim.tasks.pop_front();
+                return index;
+            }
+        }
+
+        return std::nullopt;
+    }
+};
+
+}
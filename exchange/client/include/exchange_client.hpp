@@ -1,23 +1,101 @@
 #pragma once
 
-#include "client.hpp"
+#include <expected>
+#include <unordered_map>
+#include <vector>
+
+#include "session.hpp"
+#include "shm_transport.hpp"
 #include "book_order_proto.hpp"
+#include "wire_format.hpp"
 
 namespace exchange
 {
 
-class ExchangeClient
+// Keeps one connection to the exchange open for its lifetime. Requests are
+// tagged with a sequence number so several can be in flight at once, their
+// responses are matched back up by that number. Fill reports the exchange
+// pushes for resting orders are set aside as they are read. SessionType is
+// the transport, either UDSSession or ShmClient.
+template <typename SessionType>
+class BasicExchangeClient
 {
 private:
     using PacketType = order_protocol::GenericMessage;
-    using ClientType = UDSClient<PacketType>;
     
 public:
-    auto send_order(const PacketType& packet)
+    using SequenceType = order_protocol::SequenceType;
+
+    // Sends packet without waiting for its response.
+    auto submit_order(PacketType packet) -> std::expected<SequenceType, SocketError>
+    {
+        packet.sequence = m_next_sequence++;
+
+        if (auto ret = m_session.send_msg(packet))
+            return {packet.sequence};
+        else
+            return std::unexpected(ret.error());
+    }
+
+    // Blocks until the response to sequence arrives, holding on to any
+    // responses for other in-flight requests read along the way.
+    auto wait_response(SequenceType sequence) -> std::expected<PacketType, SocketError>
     {
-        auto client = ClientType{};
-        return client.send_msg_and_get_response(packet);
+        if (auto it = m_early_responses.find(sequence); it != m_early_responses.end())
+        {
+            auto response = it->second;
+            m_early_responses.erase(it);
+            return {response};
+        }
+
+        while (true)
+        {
+            auto ret = m_session.recv_msg();
+
+            if (!ret)
+                return ret;
+
+            if (ret.value().message_type == order_protocol::MessageTypeID::EXEC_REPORT)
+            {
+                m_reports.push_back(ret.value());
+                continue;
+            }
+
+            if (ret.value().sequence == sequence)
+                return ret;
+
+            m_early_responses[ret.value().sequence] = ret.value();
+        }
     }
+
+    auto send_order(const PacketType& packet) -> std::expected<PacketType, SocketError>
+    {
+        if (auto ret = submit_order(packet))
+            return wait_response(ret.value());
+        else
+            return std::unexpected(ret.error());
+    }
+
+    // Passes each fill report read so far to f, oldest first, and forgets
+    // them.
+    template <typename F>
+    auto drain_reports(F&& f) -> void
+    {
+        for (const auto& report: m_reports)
+            f(report.details.exec);
+
+        m_reports.clear();
+    }
+
+private:
+    SessionType m_session;
+    SequenceType m_next_sequence = 1;
+    std::unordered_map<SequenceType, PacketType> m_early_responses;
+    std::vector<PacketType> m_reports;
 };
+
+using ExchangeClient = BasicExchangeClient<
+    UDSSession<order_protocol::GenericMessage, order_protocol::GenericMessage, order_protocol::wire_codec>>;
+using ShmExchangeClient = BasicExchangeClient<ShmClient<order_protocol::GenericMessage>>;
     
 }
@@ -25,5 +25,22 @@ int main(int argc, const char *argv[])
         std::cout << "Send error!\n";
     }
 
+    // Pipeline a pair of orders on the same connection, then collect the
+    // responses out of order.
+    auto first = client.submit_order(packet);
+    auto second = client.submit_order(packet);
+
+    if (first && second)
+    {
+        auto second_response = client.wait_response(second.value());
+        auto first_response = client.wait_response(first.value());
+
+        std::cout << int(first_response && second_response) << std::endl;
+    }
+    else
+    {
+        std::cout << "Send error!\n";
+    }
+
     return 0;
 }
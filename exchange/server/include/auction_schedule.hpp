@@ -0,0 +1,64 @@
+#pragma once
+
+// C++
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include "book_order_proto.hpp"
+
+namespace exchange
+{
+
+// When an instrument trading in call auctions is uncrossed: once order_count
+// orders have arrived since the last auction, or interval after it,
+// whichever comes first. Zero turns either trigger off.
+struct AuctionConfig
+{
+    std::size_t order_count = 0;
+    std::chrono::milliseconds interval{0};
+};
+
+// Instruments trading in call auctions. Every other instrument matches
+// continuously.
+using AuctionSchedule = std::unordered_map<order_protocol::InstrumentIDType, AuctionConfig>;
+
+// Parses EXCHANGE_AUCTIONS, a comma separated list of
+// <instrument>:<order count>:<interval ms>, e.g. "3:0:100,7:64:0".
+inline auto auction_schedule_from_env() -> AuctionSchedule
+{
+    auto schedule = AuctionSchedule{};
+    auto value = std::getenv("EXCHANGE_AUCTIONS");
+
+    if (!value)
+        return schedule;
+
+    auto entries = std::istringstream{value};
+    auto entry = std::string{};
+
+    while (std::getline(entries, entry, ','))
+    {
+        auto instrument = order_protocol::InstrumentIDType{};
+        auto config = AuctionConfig{};
+        auto interval = 0ull;
+        auto first = ' ';
+        auto second = ' ';
+        auto fields = std::istringstream{entry};
+
+        fields >> instrument >> first >> config.order_count >> second >> interval;
+        config.interval = std::chrono::milliseconds{interval};
+
+        if (!fields || first != ':' || second != ':' || (!config.order_count && !config.interval.count()))
+            throw std::runtime_error(std::format("Invalid auction schedule entry \"{}\" in EXCHANGE_AUCTIONS.\n", entry));
+
+        schedule.insert_or_assign(instrument, config);
+    }
+
+    return schedule;
+}
+
+}
@@ -0,0 +1,311 @@
+#pragma once
+
+// C++
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "auction_schedule.hpp"
+#include "book.hpp"
+#include "book_order_proto.hpp"
+#include "book_registry.hpp"
+#include "journal.hpp"
+#include "async_logger.hpp"
+
+namespace exchange
+{
+
+// Applies a single message to the book of the instrument it names. Runs on
+// the matching thread that owns that book. Each message type is applied by
+// its own overload, picked at compile time by order_protocol::visit_message.
+//
+// When the Sink can take reports, each resting order's sink is kept so that
+// fills against it are pushed to the session that placed it. With a journal,
+// every message applied is appended to it along with the id of the order it
+// left resting.
+//
+// Instruments in the auction schedule have their books put in call auction
+// mode. tick() raises an AUCTION message for each when it is due, which is
+// applied, journalled and reported like any other, so replaying a journal
+// uncrosses at the same points without needing a schedule to trigger them.
+template <typename Sink>
+struct BookMessageHandler
+{
+    using BookType = Book;
+    using OrderIDType = BookType::OrderIDType;
+    using BookMap = std::unordered_map<order_protocol::InstrumentIDType, BookType>;
+    using Clock = std::chrono::steady_clock;
+
+    BookMessageHandler() = default;
+
+    explicit BookMessageHandler(Journal* journal, const AuctionSchedule& auctions = {}):
+        m_journal(journal)
+    {
+        auto now = Clock::now();
+
+        for (const auto& [instrument, config]: auctions)
+        {
+            m_auctions.try_emplace(instrument, Auction{config, 0, now + config.interval});
+
+            if (config.interval.count())
+                m_next_deadline = std::min(m_next_deadline, now + config.interval);
+        }
+    }
+
+    // Drops the auctions of instruments serves() says are not this copy's,
+    // so a shard only wakes for deadlines of books it owns.
+    template <typename Predicate>
+    auto retain_instruments(Predicate serves) -> void
+    {
+        std::erase_if(m_auctions, [&](const auto& entry){ return !serves(entry.first); });
+        m_next_deadline = Clock::time_point::max();
+
+        for (const auto& [instrument, auction]: m_auctions)
+            if (auction.config.interval.count())
+                m_next_deadline = std::min(m_next_deadline, auction.deadline);
+    }
+
+    auto operator()(BookType& book, const order_protocol::GenericMessage& msg, const Sink& sink) -> order_protocol::GenericMessage
+    {
+        auto auction = find_auction(msg.instrument_id);
+
+        if (auction && book.mode() != matching_mode::CALL_AUCTION)
+            book.set_matching_mode(matching_mode::CALL_AUCTION);
+
+        auto response = order_protocol::GenericMessage{};
+        response.instrument_id = msg.instrument_id;
+        response.sequence = msg.sequence;
+
+        auto known = order_protocol::visit_message(msg, [&](auto type, const auto& details){
+            apply(book, type, details, response);
+        });
+
+        if (!known)
+            unexpected_message();
+
+        if (m_journal)
+            m_journal->append(msg, resting_order_id(response));
+
+        if constexpr (ReportSink<Sink>)
+            report_fills(book, msg, response, sink);
+
+        // Orders the book rejected do not count towards an auction.
+        if (auction && msg.message_type == order_protocol::MessageTypeID::LIMIT &&
+            (response.details.lresp.filled || response.details.lresp.order_id != BookType::REJECTED) &&
+            ++auction->orders == auction->config.order_count)
+            m_orders_due = true;
+
+        return response;
+    }
+
+    // Runs the auctions that are due, on the thread owning books. Only reads
+    // the clock when some auction runs on an interval.
+    auto tick(BookMap& books) -> void
+    {
+        if (!m_orders_due && m_next_deadline == Clock::time_point::max())
+            return;
+
+        auto now = m_next_deadline == Clock::time_point::max() ? Clock::time_point{} : Clock::now();
+
+        if (!m_orders_due && now < m_next_deadline)
+            return;
+
+        m_orders_due = false;
+        m_next_deadline = Clock::time_point::max();
+
+        for (auto& [instrument, auction]: m_auctions)
+        {
+            auto interval = auction.config.interval;
+
+            if ((auction.config.order_count && auction.orders >= auction.config.order_count) ||
+                (interval.count() && now >= auction.deadline))
+            {
+                run_auction(books, instrument);
+                auction.orders = 0;
+                auction.deadline = now + interval;
+            }
+
+            if (interval.count())
+                m_next_deadline = std::min(m_next_deadline, auction.deadline);
+        }
+    }
+
+    // When tick() next has an auction to run, time_point::max() if none is
+    // on a timer.
+    auto next_deadline() const -> Clock::time_point
+    {
+        return m_orders_due ? Clock::time_point{} : m_next_deadline;
+    }
+
+    // Id of the order a response says was left resting, if any.
+    static auto resting_order_id(const order_protocol::GenericMessage& response) -> uint64_t
+    {
+        if (response.message_type == order_protocol::MessageTypeID::LIM_RESP && !response.details.lresp.filled)
+            return response.details.lresp.order_id;
+
+        return NO_ORDER_ID;
+    }
+
+private:
+    struct Auction
+    {
+        AuctionConfig config;
+        // Orders since the last auction.
+        std::size_t orders;
+        Clock::time_point deadline;
+    };
+
+    Journal* m_journal = nullptr;
+    // Owner of every resting order on this shard's books.
+    std::unordered_map<OrderIDType, Sink> m_owners;
+    std::unordered_map<order_protocol::InstrumentIDType, Auction> m_auctions;
+    bool m_orders_due = false;
+    // Earliest interval auction, max when there are none.
+    Clock::time_point m_next_deadline = Clock::time_point::max();
+
+    auto find_auction(order_protocol::InstrumentIDType instrument) -> Auction*
+    {
+        if (m_auctions.empty())
+            return nullptr;
+
+        auto it = m_auctions.find(instrument);
+        return it == m_auctions.end() ? nullptr : &it->second;
+    }
+
+    // Uncrosses instrument's book if it is on this shard and crossed. A book
+    // that is not would be left as it is, so nothing is journalled for it.
+    auto run_auction(BookMap& books, order_protocol::InstrumentIDType instrument) -> void
+    {
+        auto it = books.find(instrument);
+
+        if (it == books.end())
+            return;
+
+        auto& book = it->second;
+        auto bid = book.best_bid();
+        auto ask = book.best_ask();
+
+        if (!bid || !ask || *bid < *ask)
+            return;
+
+        auto message = order_protocol::GenericMessage{};
+        message.message_type = order_protocol::MessageTypeID::AUCTION;
+        message.instrument_id = instrument;
+
+        (*this)(book, message, Sink{});
+    }
+
+    auto report_fills(BookType& book,
+                      const order_protocol::GenericMessage& msg,
+                      const order_protocol::GenericMessage& response,
+                      const Sink& sink) -> void
+    {
+        if (msg.message_type == order_protocol::MessageTypeID::CANCEL)
+        {
+            if (response.details.cresp.cancelled)
+                m_owners.erase(msg.details.can.order_id);
+
+            return;
+        }
+
+        if (msg.message_type != order_protocol::MessageTypeID::LIMIT &&
+            msg.message_type != order_protocol::MessageTypeID::FOK &&
+            msg.message_type != order_protocol::MessageTypeID::AUCTION)
+            return;
+
+        for (const auto& fill: book.fills())
+        {
+            auto it = m_owners.find(fill.resting_id);
+
+            if (it == m_owners.end())
+                continue;
+
+            auto report = order_protocol::GenericMessage{};
+            report.message_type = order_protocol::MessageTypeID::EXEC_REPORT;
+            report.instrument_id = msg.instrument_id;
+            report.details.exec = order_protocol::ExecutionReportDetails{fill.resting_id,
+                                                         fill.size,
+                                                         fill.price,
+                                                         fill.resting_remaining};
+
+            it->second.report(report);
+
+            if (!fill.resting_remaining)
+                m_owners.erase(it);
+        }
+
+        if (msg.message_type == order_protocol::MessageTypeID::LIMIT && !response.details.lresp.filled &&
+            response.details.lresp.order_id != BookType::REJECTED)
+            m_owners.insert_or_assign(response.details.lresp.order_id, sink);
+    }
+
+    static auto apply(BookType& book,
+                      order_protocol::message_tag<order_protocol::MessageTypeID::LIMIT>,
+                      const order_protocol::LimitDetails& details,
+                      order_protocol::GenericMessage& response) -> void
+    {
+        response.message_type = order_protocol::MessageTypeID::LIM_RESP;
+
+        auto order_id = details.side == order_protocol::Side::BUY ?
+                            book.limit_buy(details.volume, details.price) :
+                            book.limit_sell(details.volume, details.price);
+
+        if (order_id == BookType::FILLED)
+            response.details.lresp.filled = true;
+        else
+        {
+            response.details.lresp.filled = false;
+            response.details.lresp.order_id = order_id;
+        }
+    }
+
+    static auto apply(BookType& book,
+                      order_protocol::message_tag<order_protocol::MessageTypeID::FOK>,
+                      const order_protocol::FOKDetails& details,
+                      order_protocol::GenericMessage& response) -> void
+    {
+        response.message_type = order_protocol::MessageTypeID::FOK_RESP;
+        response.details.fresp.filled = details.side == order_protocol::Side::BUY ?
+                                            book.fok_buy(details.volume, details.price) :
+                                            book.fok_sell(details.volume, details.price);
+    }
+
+    static auto apply(BookType& book,
+                      order_protocol::message_tag<order_protocol::MessageTypeID::CANCEL>,
+                      const order_protocol::CancelDetails& details,
+                      order_protocol::GenericMessage& response) -> void
+    {
+        response.message_type = order_protocol::MessageTypeID::CAN_RESP;
+        response.details.cresp.cancelled = book.cancel_order(details.order_id);
+    }
+
+    static auto apply(BookType& book,
+                      order_protocol::message_tag<order_protocol::MessageTypeID::AUCTION>,
+                      const order_protocol::AuctionDetails&,
+                      order_protocol::GenericMessage& response) -> void
+    {
+        response.message_type = order_protocol::MessageTypeID::AUCTION;
+
+        auto result = book.uncross();
+        response.details.auction = {result.price, result.volume};
+    }
+
+    // Responses are never sent to the exchange.
+    template <order_protocol::MessageTypeID Type, typename Details>
+    static auto apply(BookType&, order_protocol::message_tag<Type>, const Details&, order_protocol::GenericMessage&) -> void
+    {
+        unexpected_message();
+    }
+
+    [[noreturn]] static auto unexpected_message() -> void
+    {
+        // Under normal execution we would not want to throw here
+        // as we don't want to terminate the exchange for any invalid
+        // order that is sent in, but useful for debug.
+        throw std::runtime_error("Unrecognized message type sent to exchange.");
+    }
+};
+
+}
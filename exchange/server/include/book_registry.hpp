@@ -0,0 +1,310 @@
+#pragma once
+
+// C
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// C++
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <ctime>
+#include <format>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "book_order_proto.hpp"
+#include "mpsc_queue.hpp"
+#include "order_id.hpp"
+#include "thread_affinity.hpp"
+
+namespace exchange
+{
+
+// Slot a routed request's response is written to. Owned by the submitter,
+// which must keep it alive until wait() returns.
+struct ShardCompletion
+{
+    order_protocol::GenericMessage response;
+    std::atomic<bool> ready{false};
+
+    auto wait() -> const order_protocol::GenericMessage&
+    {
+        for (auto spins = 0; spins < SPIN_LIMIT; spins++)
+            if (ready.load(std::memory_order_acquire))
+                return response;
+
+        ready.wait(false, std::memory_order_acquire);
+        return response;
+    }
+
+private:
+    static constexpr int SPIN_LIMIT = 4096;
+};
+
+// Publishes a shard's response to a submitter blocked in
+// ShardCompletion::wait().
+struct CompletionSink
+{
+    ShardCompletion* completion;
+
+    auto operator()(const order_protocol::GenericMessage& response) const -> void
+    {
+        completion->response = response;
+        completion->ready.store(true, std::memory_order_release);
+        completion->ready.notify_one();
+    }
+};
+
+// A sink that can also deliver messages the submitter did not ask for, such
+// as fill reports for its resting orders, for as long as it stays connected.
+template <typename Sink>
+concept ReportSink = requires(const Sink& sink, const order_protocol::GenericMessage& message)
+{
+    sink.report(message);
+};
+
+// Owns one book per instrument, with instruments sharded over a fixed set of
+// matching threads by instrument id. Each shard's books are only ever touched
+// by that shard's thread, requests reach it through a lock-free queue.
+//
+// Handler is invoked as handler(book, message, sink) -> response on the shard
+// thread, which passes the response to the Sink submitted alongside the
+// message. The handler may keep the sink to report to later. A handler with
+// tick(books) is also given the shard's books between messages, to act on
+// them on its own schedule, and with next_deadline() says when it next needs
+// to be. A handler with retain_instruments(serves) is told which instruments
+// its shard owns.
+//
+// An idle shard spins, then yields, then parks on a futex until a submitter
+// or the handler's next deadline wakes it.
+template <typename BookType, typename Handler, typename Sink = CompletionSink>
+requires std::is_trivially_copyable_v<Sink>
+class BookRegistry
+{
+public:
+    using InstrumentIDType = order_protocol::InstrumentIDType;
+    using MessageType = order_protocol::GenericMessage;
+
+    static constexpr std::size_t DEFAULT_QUEUE_CAPACITY = 4096;
+    static constexpr std::size_t DEFAULT_BOOK_CAPACITY = 4096;
+    // Order ids carry the instrument in their prefix, so instruments beyond
+    // it would share ids.
+    static constexpr InstrumentIDType MAX_INSTRUMENT_ID = (InstrumentIDType{1} << order_id_generator::PREFIX_BITS) - 1;
+
+    using BookMap = std::unordered_map<InstrumentIDType, BookType>;
+
+    // Each shard gets its own copy of handler, and the books of its
+    // instruments from books, restored from a snapshot say.
+    explicit BookRegistry(unsigned shard_count,
+                          unsigned first_core = 0,
+                          std::size_t queue_capacity = DEFAULT_QUEUE_CAPACITY,
+                          const Handler& handler = Handler{},
+                          BookMap books = {})
+    {
+        if (!shard_count)
+            shard_count = 1;
+
+        for (auto i = 0u; i < shard_count; i++)
+            m_shards.push_back(std::make_unique<Shard>(queue_capacity, handler));
+
+        while (!books.empty())
+        {
+            auto node = books.extract(books.begin());
+            m_shards[shard_of(node.key())]->books.insert(std::move(node));
+        }
+
+        for (auto i = 0u; i < shard_count; i++)
+        {
+            auto& shard = *m_shards[i];
+
+            if constexpr (requires { shard.handler.retain_instruments([](InstrumentIDType){ return true; }); })
+                shard.handler.retain_instruments([this, i](InstrumentIDType instrument){
+                    return shard_of(instrument) == i;
+                });
+
+            shard.thread = std::jthread{[&shard, core = first_core + i](std::stop_token stop){
+                pin_current_thread(core);
+                run_shard(stop, shard);
+            }};
+        }
+    }
+
+    BookRegistry(const BookRegistry& other) = delete;
+    BookRegistry operator=(const BookRegistry& other) = delete;
+
+    BookRegistry(BookRegistry&& other) = delete;
+    BookRegistry operator=(BookRegistry&& other) = delete;
+
+    // Routes message to the shard owning its instrument. The response is
+    // handed to sink on that shard's thread.
+    auto submit(const MessageType& message, Sink sink) -> void
+    {
+        while (!try_submit(message, sink))
+            std::this_thread::yield();
+    }
+
+    // As submit(), returning false if the shard's queue is full. Submitters
+    // the shard may itself be waiting on, to deliver reports say, should
+    // make way for it before trying again.
+    auto try_submit(const MessageType& message, Sink sink) -> bool
+    {
+        auto& shard = *m_shards[shard_of(message.instrument_id)];
+
+        if (!shard.queue.try_push(Request{ message, sink }))
+            return false;
+
+        shard.wake();
+        return true;
+    }
+
+    // Whether messages for instrument can be submitted.
+    static constexpr auto serves(InstrumentIDType instrument) -> bool
+    {
+        return instrument <= MAX_INSTRUMENT_ID;
+    }
+
+    auto shard_of(InstrumentIDType instrument) const -> std::size_t
+    {
+        return instrument % m_shards.size();
+    }
+
+    auto shard_count() const -> std::size_t
+    {
+        return m_shards.size();
+    }
+
+    // The book of instrument in books, created as the registry creates
+    // books if there is none.
+    static auto find_or_create_book(BookMap& books, InstrumentIDType instrument) -> BookType&
+    {
+        if (auto it = books.find(instrument); it != books.end())
+            return it->second;
+
+        if (!serves(instrument))
+            throw std::out_of_range(std::format("Instrument {} is beyond the order id prefix.", instrument));
+
+        // Order ids carry the instrument so they are unique exchange wide.
+        return books.try_emplace(instrument,
+                                 DEFAULT_BOOK_CAPACITY,
+                                 static_cast<uint16_t>(instrument)).first->second;
+    }
+
+private:
+    static constexpr int IDLE_SPIN_LIMIT = 1024;
+    // Empty polls, spinning then yielding, before a shard parks.
+    static constexpr int IDLE_PARK_LIMIT = 4096;
+
+    struct Request
+    {
+        MessageType message;
+        Sink sink;
+    };
+
+    struct Shard
+    {
+        Shard(std::size_t queue_capacity, const Handler& handler):
+            queue(queue_capacity),
+            handler(handler)
+        {}
+
+        MPSCQueue<Request> queue;
+        BookMap books;
+        Handler handler;
+        std::jthread thread;
+        // Bumped to wake the shard while it is parked.
+        std::atomic<uint32_t> bell{0};
+        std::atomic<bool> parked{false};
+
+        // Submitter side, after a push. Costs a fence, and a syscall only if
+        // the shard is parked.
+        auto wake() -> void
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (parked.load(std::memory_order_relaxed) && parked.exchange(false))
+            {
+                bell.fetch_add(1, std::memory_order_release);
+                syscall(SYS_futex, reinterpret_cast<uint32_t*>(&bell), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+            }
+        }
+    };
+
+    std::vector<std::unique_ptr<Shard>> m_shards;
+
+    static auto book_for(Shard& shard, InstrumentIDType instrument) -> BookType&
+    {
+        return find_or_create_book(shard.books, instrument);
+    }
+
+    // Sleeps until woken, the handler's next deadline or stop, unless
+    // something arrived while parking.
+    static auto park(std::stop_token stop, Shard& shard) -> void
+    {
+        auto seen = shard.bell.load(std::memory_order_acquire);
+        auto timeout = timespec{};
+        auto timeout_ptr = static_cast<timespec*>(nullptr);
+
+        if constexpr (requires { shard.handler.next_deadline(); })
+        {
+            auto deadline = shard.handler.next_deadline();
+            using Clock = typename decltype(deadline)::clock;
+
+            if (deadline != Clock::time_point::max())
+            {
+                auto wait = std::max(std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - Clock::now()),
+                                     std::chrono::nanoseconds{0});
+                timeout.tv_sec = wait.count() / 1'000'000'000;
+                timeout.tv_nsec = wait.count() % 1'000'000'000;
+                timeout_ptr = &timeout;
+            }
+        }
+
+        shard.parked.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (shard.queue.empty() && !stop.stop_requested())
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&shard.bell), FUTEX_WAIT_PRIVATE, seen, timeout_ptr, nullptr, 0);
+
+        shard.parked.store(false, std::memory_order_relaxed);
+    }
+
+    static auto run_shard(std::stop_token stop, Shard& shard) -> void
+    {
+        auto request = Request{};
+        auto idle = 0;
+        auto wake_on_stop = std::stop_callback{stop, [&shard]{ shard.wake(); }};
+
+        while (!stop.stop_requested())
+        {
+            if constexpr (requires { shard.handler.tick(shard.books); })
+                shard.handler.tick(shard.books);
+
+            if (!shard.queue.try_pop(request))
+            {
+                if (++idle < IDLE_SPIN_LIMIT)
+                    continue;
+
+                if (idle < IDLE_PARK_LIMIT)
+                    std::this_thread::yield();
+                else
+                    park(stop, shard);
+
+                continue;
+            }
+
+            idle = 0;
+
+            auto& book = book_for(shard, request.message.instrument_id);
+            request.sink(shard.handler(book, request.message, request.sink));
+        }
+    }
+};
+
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+// C++
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "auction_schedule.hpp"
+#include "book.hpp"
+#include "book_message_handler.hpp"
+#include "book_order_proto.hpp"
+#include "book_registry.hpp"
+#include "journal.hpp"
+
+namespace exchange
+{
+
+// For applying messages nobody is waiting on an answer to.
+struct DiscardSink
+{
+    auto operator()(const order_protocol::GenericMessage&) const -> void {}
+};
+
+// Snapshot file written by ExchangeState::save(), in host byte order:
+//
+//     "EXSNAP1\0" | u64 journal sequence | u64 book count
+//     per book:    u64 instrument | book snapshot (see book_snapshot.hpp)
+struct ExchangeSnapshotHeader
+{
+    static constexpr std::array<char, 8> MAGIC = {'E', 'X', 'S', 'N', 'A', 'P', '1', '\0'};
+
+    std::array<char, 8> magic;
+    uint64_t sequence;
+    uint64_t book_count;
+};
+
+// Every book of the exchange as of some record of its journal. Starting up
+// loads the latest snapshot and replays only the journal records after it,
+// so takes time in proportion to the orders resting rather than to history.
+class ExchangeState
+{
+public:
+    using RegistryType = BookRegistry<Book, BookMessageHandler<DiscardSink>, DiscardSink>;
+    using BookMap = RegistryType::BookMap;
+
+    // Books of instruments in auctions are put in call auction mode as the
+    // journal reaches them, uncrossing where its AUCTION records say.
+    explicit ExchangeState(const AuctionSchedule& auctions = {}):
+        m_handler(nullptr, auctions)
+    {}
+
+    struct ReplayStats
+    {
+        std::size_t applied = 0;
+        // Records whose order was given a different id than it was live.
+        std::size_t mismatches = 0;
+    };
+
+    // Number of journal records applied to the books.
+    auto sequence() const -> uint64_t
+    {
+        return m_sequence;
+    }
+
+    auto books() -> BookMap&
+    {
+        return m_books;
+    }
+
+    auto take_books() -> BookMap
+    {
+        return std::move(m_books);
+    }
+
+    // Applies the journal's records from the one after sequence() on.
+    auto replay(const JournalReader& journal) -> ReplayStats
+    {
+        auto stats = ReplayStats{};
+
+        stats.applied = journal.for_each([&](uint64_t sequence,
+                                             const order_protocol::GenericMessage& message,
+                                             uint64_t order_id){
+            m_sequence = sequence;
+
+            // Never accepted from clients, so only in a journal written before
+            // instruments were limited to the order id prefix.
+            if (!RegistryType::serves(message.instrument_id))
+            {
+                stats.mismatches++;
+                return;
+            }
+
+            auto& book = RegistryType::find_or_create_book(m_books, message.instrument_id);
+            auto response = m_handler(book, message, DiscardSink{});
+
+            if (BookMessageHandler<DiscardSink>::resting_order_id(response) != order_id)
+                stats.mismatches++;
+        }, m_sequence);
+
+        return stats;
+    }
+
+    // Writes to a temporary file renamed over path, so a crash part way
+    // leaves the previous snapshot in place.
+    auto save(const std::string& path) -> bool
+    {
+        auto temporary = path + ".tmp";
+
+        {
+            auto out = std::ofstream{temporary, std::ios::binary | std::ios::trunc};
+            auto header = ExchangeSnapshotHeader{ExchangeSnapshotHeader::MAGIC, m_sequence, m_books.size()};
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+            for (auto& [instrument, book]: m_books)
+            {
+                auto id = uint64_t{instrument};
+                out.write(reinterpret_cast<const char*>(&id), sizeof(id));
+
+                if (!book.save(out))
+                    return false;
+            }
+
+            if (!out.flush())
+                return false;
+        }
+
+        return std::rename(temporary.c_str(), path.c_str()) == 0;
+    }
+
+    // Loads a snapshot into a state with no books. Returns false if it
+    // cannot be read, leaving the state as it was.
+    auto load(const std::string& path) -> bool
+    {
+        auto in = std::ifstream{path, std::ios::binary};
+        auto header = ExchangeSnapshotHeader{};
+        in.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+        if (!in || header.magic != ExchangeSnapshotHeader::MAGIC || !m_books.empty())
+            return false;
+
+        auto books = BookMap{};
+
+        for (auto i = uint64_t{0}; i < header.book_count; i++)
+        {
+            auto instrument = uint64_t{0};
+            in.read(reinterpret_cast<char*>(&instrument), sizeof(instrument));
+
+            if (!in || !RegistryType::serves(instrument) ||
+                !RegistryType::find_or_create_book(books, instrument).restore(in))
+                return false;
+        }
+
+        m_books = std::move(books);
+        m_sequence = header.sequence;
+
+        return true;
+    }
+
+private:
+    uint64_t m_sequence = 0;
+    BookMap m_books;
+    BookMessageHandler<DiscardSink> m_handler;
+};
+
+// Snapshot to start from, named by EXCHANGE_SNAPSHOT.
+inline auto snapshot_path_from_env() -> std::optional<std::string>
+{
+    auto path = std::getenv("EXCHANGE_SNAPSHOT");
+
+    if (!path || !*path)
+        return std::nullopt;
+
+    return path;
+}
+
+}
@@ -1,102 +1,208 @@
+#include <chrono>
 #include <iostream>
 #include <format>
+#include <filesystem>
 #include <functional>
+#include <thread>
+#include <string>
+#include <memory>
+#include <optional>
+#include <span>
 
 #include "server.hpp"
+#include "shm_transport.hpp"
+#include "transport.hpp"
 #include "book_order_proto.hpp"
+#include "wire_format.hpp"
 #include "book.hpp"
+#include "book_registry.hpp"
+#include "auction_schedule.hpp"
+#include "book_message_handler.hpp"
+#include "exchange_state.hpp"
+#include "journal.hpp"
+#include "async_logger.hpp"
 
 using namespace order_protocol;
 using namespace exchange;
 
-class ExchangeServer
+// Socket transport. I/O threads decode requests and queue them for the
+// matching shards, which queue each response back to the I/O thread that
+// read its request, so matching never waits on a socket. Fill reports for
+// resting orders travel back the same way. Messages clients may not send, or
+// for instruments beyond the registry's range, are answered with REJECT and
+// never reach a book. The handler is a template
+// argument of the server, so nothing between the decoded frame and the book
+// is type erased.
+class PipelinedExchangeServer
 {
 public:
-    using BookType = Book;
-    using OrderIDType = BookType::OrderIDType;
+    using AddressType = ReplyAddress<GenericMessage>;
 
-    ExchangeServer()
+    struct ReplySink
     {
-        auto handler_wrapper = [&](auto message){
-            return this->handle_message(message);
-        };
-        m_server.post_response_gen_callback(handler_wrapper);   
-        m_server.start_server();    
-    }
+        AddressType address;
 
-private:
-    auto handle_message(GenericMessage msg) -> GenericMessage
-    {
-        auto response = GenericMessage{};
-
-        switch (msg.message_type)
+        auto operator()(const GenericMessage& response) const -> void
         {
-        case MessageTypeID::LIMIT:
+            address.reply(response);
+        }
+
+        auto report(const GenericMessage& message) const -> void
         {
-            response.message_type = MessageTypeID::LIM_RESP;
+            address.notify(message);
+        }
+    };
 
-            auto order_id = OrderIDType{};
+    using RegistryType = BookRegistry<Book, BookMessageHandler<ReplySink>, ReplySink>;
 
-            if (msg.details.lim.side == Side::BUY)
-                order_id = m_book.limit_buy(msg.details.lim.volume,
-                                            msg.details.lim.price);
-            else
-                order_id = m_book.limit_sell(msg.details.lim.volume,
-                                            msg.details.lim.price);
+    struct Handler
+    {
+        RegistryType* registry;
 
-            if (order_id == -1)
-                response.details.lresp.filled = true;
-            else
+        // Stops at the first message whose shard is full, so the I/O thread
+        // can drain the reports that shard may be waiting to push.
+        auto handle_async(const AddressType& address, std::span<const GenericMessage> messages) -> std::size_t
+        {
+            auto taken = std::size_t{0};
+
+            for (const auto& message: messages)
             {
-                response.details.lresp.filled = false;
-                response.details.lresp.order_id = order_id;
+                if (!is_client_request(message.message_type) || !RegistryType::serves(message.instrument_id))
+                    address.reply(rejection(message));
+                else if (!registry->try_submit(message, ReplySink{ address }))
+                    break;
+
+                taken++;
             }
 
-            break;
-        }
-        case MessageTypeID::FOK:
-        {
-            response.message_type = MessageTypeID::FOK_RESP;
-    
-            auto filled = false;
-    
-            if (msg.details.fok.side == Side::BUY)
-                filled = m_book.fok_buy(msg.details.lim.volume,
-                                        msg.details.lim.price);
-            else
-                filled = m_book.fok_sell(msg.details.lim.volume,
-                                         msg.details.lim.price);
-    
-            response.details.fresp.filled = filled;
-    
-            break;
+            return taken;
         }
-        case MessageTypeID::CANCEL:
-        {
-            response.message_type = MessageTypeID::CAN_RESP;
+    };
+
+    using ServerType = UDSServer<GenericMessage, GenericMessage, wire_codec, Handler>;
+
+    PipelinedExchangeServer(unsigned matching_threads,
+                            unsigned io_threads,
+                            Journal* journal,
+                            const AuctionSchedule& auctions,
+                            RegistryType::BookMap books):
+        m_registry(matching_threads,
+                   io_threads,
+                   RegistryType::DEFAULT_QUEUE_CAPACITY,
+                   BookMessageHandler<ReplySink>{journal, auctions},
+                   std::move(books)),
+        m_server(Handler{ &m_registry })
+    {
+        m_server.start_event_loop(io_threads);
+    }
+
+private:
+    RegistryType m_registry;
+    ServerType m_server;
+};
 
-            response.details.cresp.cancelled =
-                    m_book.cancel_order(msg.details.can.order_id);
+// Transports taking callbacks, where each request is matched while the
+// transport waits for it.
+template <typename ServerType>
+class ExchangeServer
+{
+public:
+    // Requests are answered while the client waits, so there is nowhere to
+    // push fill reports to.
+    using RegistryType = BookRegistry<Book, BookMessageHandler<CompletionSink>>;
+
+    ExchangeServer(unsigned matching_threads,
+                   unsigned io_threads,
+                   Journal* journal,
+                   const AuctionSchedule& auctions,
+                   RegistryType::BookMap books):
+        m_registry(matching_threads,
+                   io_threads,
+                   RegistryType::DEFAULT_QUEUE_CAPACITY,
+                   BookMessageHandler<CompletionSink>{journal, auctions},
+                   std::move(books))
+    {
+        auto handler_wrapper = [&](const GenericMessage& message){
+            return this->handle_message(message);
+        };
+        m_server.post_response_gen_callback(handler_wrapper);
+        m_server.start_event_loop();
+    }
 
-            break;
-        }
-        default:
-            // Under normal execution we would not want to throw here
-            // as we don't want to terminate the exchange for any invalid
-            // order that is sent in, but useful for debug.
-            throw std::runtime_error("Unrecognized message type sent to exchange.");
-        }
+private:
+    auto handle_message(const GenericMessage& msg) -> GenericMessage
+    {
+        if (!is_client_request(msg.message_type) || !RegistryType::serves(msg.instrument_id))
+            return rejection(msg);
 
-        return response;
+        auto completion = ShardCompletion{};
+        m_registry.submit(msg, CompletionSink{ &completion });
+        return completion.wait();
     }
 
-    UDSServer<GenericMessage> m_server;
-    BookType m_book;
+    ServerType m_server;
+    RegistryType m_registry;
 };
 
+// Books as they were when the exchange last stopped: the snapshot named by
+// EXCHANGE_SNAPSHOT, if any, then whatever the journal recorded after it.
+static auto restore_books(const std::optional<JournalConfig>& journal,
+                          const AuctionSchedule& auctions) -> ExchangeState::BookMap
+{
+    auto state = ExchangeState{auctions};
+    auto start = std::chrono::steady_clock::now();
+
+    if (auto snapshot = snapshot_path_from_env(); snapshot && std::filesystem::exists(*snapshot))
+        if (!state.load(*snapshot))
+            throw std::runtime_error(std::format("Unable to load snapshot {}\n", *snapshot));
+
+    auto applied = std::size_t{0};
+
+    if (journal && std::filesystem::exists(journal->path))
+        applied = state.replay(JournalReader{journal->path}).applied;
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    if (state.sequence())
+        log_info<"Restored {} books to journal sequence {}, replaying {} records, in {} ms.">(
+            state.books().size(), state.sequence(), applied, elapsed.count());
+
+    return state.take_books();
+}
+
 int main(int argc, const char *argv[])
 {
-    auto server = ExchangeServer{};
+    // One I/O thread, the rest of the cores match, unless told otherwise.
+    // Matching threads are pinned to the cores after the I/O threads'.
+    auto cores = std::thread::hardware_concurrency();
+    auto io_threads = 1u;
+    auto matching_threads = cores > 1 ? cores - 1 : 1;
+
+    if (argc > 1)
+        matching_threads = std::stoul(argv[1]);
+
+    if (argc > 2)
+        io_threads = std::stoul(argv[2]);
+
+    // Instruments named in EXCHANGE_AUCTIONS trade in call auctions.
+    auto auctions = auction_schedule_from_env();
+
+    // Every accepted message is journalled when EXCHANGE_JOURNAL names a file.
+    auto journal_config = journal_config_from_env();
+    auto books = restore_books(journal_config, auctions);
+    auto journal = std::unique_ptr<Journal>{};
+
+    if (journal_config)
+        journal = std::make_unique<Journal>(*journal_config);
+
+    if (transport_from_env() == Transport::SHM)
+        auto server = ExchangeServer<ShmServer<GenericMessage>>{matching_threads,
+                                                                io_threads,
+                                                                journal.get(),
+                                                                auctions,
+                                                                std::move(books)};
+    else
+        auto server = PipelinedExchangeServer{matching_threads, io_threads, journal.get(), auctions, std::move(books)};
 
     return 0;
 }
@@ -0,0 +1,84 @@
+#include <chrono>
+#include <iostream>
+#include <format>
+#include <string>
+
+#include "auction_schedule.hpp"
+#include "exchange_state.hpp"
+#include "journal.hpp"
+
+using namespace exchange;
+
+// journal_replay <journal> [--from snapshot] [--save snapshot]
+//
+// Rebuilds every book by applying a journal's messages in order, with the
+// handler the exchange matches with, and checks each order is given the id
+// it was given live. Starting from a snapshot only the records after it are
+// applied. Saving writes a snapshot as of the end of the journal, for the
+// exchange to start from. Instruments the exchange ran call auctions for
+// must be named in EXCHANGE_AUCTIONS as they were for it.
+int main(int argc, const char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: journal_replay <journal> [--from snapshot] [--save snapshot]\n";
+        return 1;
+    }
+
+    auto from = std::string{};
+    auto save = std::string{};
+
+    for (auto i = 2; i + 1 < argc; i += 2)
+    {
+        auto option = std::string{argv[i]};
+
+        if (option == "--from")
+            from = argv[i + 1];
+        else if (option == "--save")
+            save = argv[i + 1];
+        else
+        {
+            std::cerr << std::format("Unknown option {}\n", option);
+            return 1;
+        }
+    }
+
+    auto state = ExchangeState{auction_schedule_from_env()};
+    auto start = std::chrono::steady_clock::now();
+
+    if (!from.empty() && !state.load(from))
+    {
+        std::cerr << std::format("Unable to load snapshot {}\n", from);
+        return 1;
+    }
+
+    auto loaded = std::chrono::steady_clock::now();
+    auto journal = JournalReader{argv[1]};
+    auto stats = state.replay(journal);
+    auto replayed = std::chrono::steady_clock::now();
+
+    auto seconds = [](auto duration){ return std::chrono::duration<double>(duration).count(); };
+
+    std::cout << std::format("Snapshot:           sequence {}, {} s\n", state.sequence() - stats.applied, seconds(loaded - start));
+    std::cout << std::format("Replayed:           {} records to sequence {} of {}, {} s\n",
+                             stats.applied, state.sequence(), journal.size(), seconds(replayed - loaded));
+    std::cout << std::format("Instruments:        {}\n", state.books().size());
+
+    for (auto& [instrument, book]: state.books())
+        std::cout << std::format("  {}: bid depth {}, ask depth {}\n", instrument, book.bid_depth(), book.ask_depth());
+
+    std::cout << std::format("Id mismatches:      {}\n", stats.mismatches);
+
+    if (!save.empty())
+    {
+        if (!state.save(save))
+        {
+            std::cerr << std::format("Unable to save snapshot {}\n", save);
+            return 1;
+        }
+
+        std::cout << std::format("Saved:              {} at sequence {}\n", save, state.sequence());
+    }
+
+    return state.sequence() == journal.size() && !stats.mismatches ? 0 : 1;
+}
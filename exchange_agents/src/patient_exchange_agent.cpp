@@ -5,11 +5,14 @@
 
 #include "patient_agent.hpp"
 #include "exchange_client.hpp"
+#include "transport.hpp"
 #include "book_order_proto.hpp"
+#include "async_logger.hpp"
 
 namespace exchange
 {
 
+template <typename ClientType>
 class PatientExchangeAgent
 {
 public:
@@ -32,6 +35,12 @@ public:
 
     auto act()
     {
+        // Orders reported filled since the last step are no longer worth
+        // cancelling.
+        m_client.drain_reports([&](const order_protocol::ExecutionReportDetails& report){
+            m_agent.on_execution(report.order_id, report.remaining);
+        });
+
         return m_agent.act();
     }
 private:
@@ -41,7 +50,7 @@ private:
     static constexpr std::size_t order_size = 10;
 
     PatientAgent m_agent;
-    ExchangeClient m_client;
+    ClientType m_client;
 
     bool cancel_callback(PatientAgent::OrderIDType order_id)
     {
@@ -77,16 +86,19 @@ private:
             auto response = ret.value();
 
             if (response.message_type != order_protocol::MessageTypeID::LIM_RESP)
-                std::cout << "Somehow we got the wrong response type.\n";
+                log_warn<"Somehow we got the wrong response type.">();
 
             if (response.details.lresp.filled)
                 return std::unexpected(PatientAgent::PlaceOutcome::FILLED_IMMEDIATELY);
 
+            if (!response.details.lresp.order_id)
+                return std::unexpected(PatientAgent::PlaceOutcome::FAILED);
+
             return {response.details.lresp.order_id};
         }
         else
         {
-            std::cout << "Send error!\n";
+            log_warn<"Send error!">();
             return std::unexpected(PatientAgent::PlaceOutcome::FAILED);
         }
     }
@@ -96,9 +108,10 @@ private:
 
 using namespace exchange;
 
-int main(int argc, const char *argv[])
+template <typename ClientType>
+auto run_agent()
 {
-    auto agent = PatientExchangeAgent{};
+    auto agent = PatientExchangeAgent<ClientType>{};
 
     auto backoff_time = std::chrono::milliseconds{1};
 
@@ -109,6 +122,14 @@ int main(int argc, const char *argv[])
 
         std::this_thread::sleep_for(backoff_time);
     }
+}
+
+int main(int argc, const char *argv[])
+{
+    if (transport_from_env() == Transport::SHM)
+        run_agent<ShmExchangeClient>();
+    else
+        run_agent<ExchangeClient>();
 
     return 0;
 }
@@ -0,0 +1,345 @@
+#pragma once
+
+// C
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// C++
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "book_order_proto.hpp"
+#include "wire_format.hpp"
+
+namespace exchange
+{
+
+// One accepted inbound message, wire encoded, with the id the book gave it.
+// Records are a cache line each so that shards appending side by side never
+// share one. sequence is written last and is slot + 1, so a reader can tell
+// where the log ends from the first slot that does not match.
+struct alignas(64) JournalRecord
+{
+    uint64_t sequence;
+    uint64_t order_id;
+    std::array<std::byte, order_protocol::wire::MAX_FRAME_SIZE> frame;
+};
+
+static_assert(sizeof(JournalRecord) == 64);
+
+// Start of the journal file, followed by capacity records.
+struct alignas(64) JournalHeader
+{
+    static constexpr std::array<char, 8> MAGIC = {'E', 'X', 'J', 'R', 'N', 'L', '1', '\0'};
+
+    std::array<char, 8> magic;
+    uint64_t capacity;
+    uint64_t record_size;
+};
+
+// Given for an order that did not rest, or a message that is not an order.
+inline constexpr uint64_t NO_ORDER_ID = static_cast<uint64_t>(-1);
+
+struct JournalConfig
+{
+    static constexpr std::size_t DEFAULT_CAPACITY = 16 * 1024 * 1024;
+
+    std::string path;
+    // Records the file is sized for up front. The file is sparse, disk is
+    // only used as records are written.
+    std::size_t capacity = DEFAULT_CAPACITY;
+    // How often written records are msync'd to disk. Records are in the
+    // page cache, and so survive the process dying, as soon as they are
+    // appended.
+    std::chrono::milliseconds sync_interval{10};
+};
+
+// Reads the journal location and sync interval from EXCHANGE_JOURNAL and
+// EXCHANGE_JOURNAL_SYNC_MS. Journaling is off while EXCHANGE_JOURNAL is unset.
+inline auto journal_config_from_env() -> std::optional<JournalConfig>
+{
+    auto path = std::getenv("EXCHANGE_JOURNAL");
+
+    if (!path || !*path)
+        return std::nullopt;
+
+    auto config = JournalConfig{};
+    config.path = path;
+
+    if (auto sync = std::getenv("EXCHANGE_JOURNAL_SYNC_MS"))
+        config.sync_interval = std::chrono::milliseconds{std::strtoull(sync, nullptr, 10)};
+
+    return config;
+}
+
+// Maps a journal file, sized for capacity records when it is created.
+class JournalMapping
+{
+public:
+    JournalMapping(const std::string& path, std::size_t capacity, bool writable)
+    {
+        m_fd = open(path.c_str(), writable ? O_RDWR | O_CREAT | O_CLOEXEC : O_RDONLY | O_CLOEXEC, 0644);
+
+        if (m_fd == -1)
+            throw std::runtime_error(std::format("Unable to open journal {}. Errno: {}\n", path, errno));
+
+        struct stat status{};
+        fstat(m_fd, &status);
+        auto existing = static_cast<std::size_t>(status.st_size);
+
+        if (existing == 0 && writable)
+        {
+            m_size = sizeof(JournalHeader) + capacity * sizeof(JournalRecord);
+
+            if (ftruncate(m_fd, m_size) == -1)
+                fail(std::format("Unable to size journal {}. Errno: {}\n", path, errno));
+        }
+        else
+            m_size = existing;
+
+        if (m_size < sizeof(JournalHeader))
+            fail(std::format("Journal {} is truncated.\n", path));
+
+        auto protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        auto addr = mmap(nullptr, m_size, protection, MAP_SHARED, m_fd, 0);
+
+        if (addr == MAP_FAILED)
+            fail(std::format("Unable to map journal {}. Errno: {}\n", path, errno));
+
+        m_base = static_cast<std::byte*>(addr);
+
+        if (existing == 0 && writable)
+        {
+            auto header = JournalHeader{JournalHeader::MAGIC, capacity, sizeof(JournalRecord)};
+            std::memcpy(m_base, &header, sizeof(header));
+        }
+
+        auto& header = *reinterpret_cast<const JournalHeader*>(m_base);
+
+        if (header.magic != JournalHeader::MAGIC ||
+            header.record_size != sizeof(JournalRecord) ||
+            sizeof(JournalHeader) + header.capacity * sizeof(JournalRecord) > m_size)
+        {
+            munmap(m_base, m_size);
+            fail(std::format("{} is not a journal this build can read.\n", path));
+        }
+    }
+
+    JournalMapping(const JournalMapping& other) = delete;
+    JournalMapping operator=(const JournalMapping& other) = delete;
+
+    JournalMapping(JournalMapping&& other) = delete;
+    JournalMapping operator=(JournalMapping&& other) = delete;
+
+    ~JournalMapping()
+    {
+        munmap(m_base, m_size);
+        close(m_fd);
+    }
+
+    auto capacity() const -> std::size_t
+    {
+        return reinterpret_cast<const JournalHeader*>(m_base)->capacity;
+    }
+
+    auto records() const -> JournalRecord*
+    {
+        return reinterpret_cast<JournalRecord*>(m_base + sizeof(JournalHeader));
+    }
+
+    // Whether slot holds a complete record.
+    auto written(std::size_t slot) const -> bool
+    {
+        return std::atomic_ref{records()[slot].sequence}.load(std::memory_order_acquire) == slot + 1;
+    }
+
+    // Number of complete records at the front of the journal.
+    auto written_count() const -> std::size_t
+    {
+        auto count = std::size_t{0};
+
+        while (count < capacity() && written(count))
+            count++;
+
+        return count;
+    }
+
+    // Flushes the pages holding bytes [begin, end) of the file to disk.
+    auto sync(std::size_t begin, std::size_t end) const -> void
+    {
+        static const auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+
+        begin -= begin % page;
+
+        if (begin < end)
+            msync(m_base + begin, end - begin, MS_SYNC);
+    }
+
+private:
+    int m_fd = -1;
+    std::byte* m_base = nullptr;
+    std::size_t m_size = 0;
+
+    [[noreturn]] auto fail(const std::string& message) -> void
+    {
+        close(m_fd);
+        throw std::runtime_error(message);
+    }
+};
+
+// Append-only log of the messages the exchange accepted, in a pre-sized
+// memory mapped file. Appending reserves a slot with one atomic add and
+// copies the record in, so matching threads never enter the kernel for it.
+// A background thread msyncs whatever has been appended every sync
+// interval, committing all of it as a group. Reopening a journal appends
+// after the records already in it.
+class Journal
+{
+public:
+    explicit Journal(const JournalConfig& config):
+        m_mapping(config.path, config.capacity, true),
+        m_sync_interval(config.sync_interval)
+    {
+        m_next.store(m_mapping.written_count(), std::memory_order_relaxed);
+        m_synced = m_next.load(std::memory_order_relaxed);
+
+        m_flusher = std::jthread{[this](std::stop_token stop){ run_flusher(stop); }};
+    }
+
+    Journal(const Journal& other) = delete;
+    Journal operator=(const Journal& other) = delete;
+
+    Journal(Journal&& other) = delete;
+    Journal operator=(Journal&& other) = delete;
+
+    ~Journal()
+    {
+        m_flusher.request_stop();
+        m_flusher.join();
+        sync();
+    }
+
+    // Safe from any number of threads. Returns false, dropping the record,
+    // once the journal is full.
+    auto append(const order_protocol::GenericMessage& message, uint64_t order_id) -> bool
+    {
+        auto slot = m_next.fetch_add(1, std::memory_order_relaxed);
+
+        if (slot >= m_mapping.capacity())
+        {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        auto& record = m_mapping.records()[slot];
+        record.order_id = order_id;
+        order_protocol::wire_codec::encode<order_protocol::GenericMessage>(message, record.frame.data());
+        std::atomic_ref{record.sequence}.store(slot + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Records appended, including any still being written.
+    auto size() const -> std::size_t
+    {
+        return std::min(m_next.load(std::memory_order_relaxed), m_mapping.capacity());
+    }
+
+    auto capacity() const -> std::size_t
+    {
+        return m_mapping.capacity();
+    }
+
+    auto dropped() const -> std::size_t
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+    // Flushes everything appended so far.
+    auto sync() -> void
+    {
+        auto end = size();
+        auto offset = [](std::size_t slot){ return sizeof(JournalHeader) + slot * sizeof(JournalRecord); };
+
+        m_mapping.sync(offset(m_synced), offset(end));
+        m_synced = end;
+    }
+
+private:
+    JournalMapping m_mapping;
+    std::chrono::milliseconds m_sync_interval;
+    alignas(64) std::atomic<std::size_t> m_next{0};
+    std::atomic<std::size_t> m_dropped{0};
+    // Flusher thread only, and the destructor once it has stopped.
+    std::size_t m_synced = 0;
+    std::mutex m_mutex;
+    std::condition_variable_any m_stop_cv;
+    std::jthread m_flusher;
+
+    auto run_flusher(std::stop_token stop) -> void
+    {
+        auto lock = std::unique_lock{m_mutex};
+
+        while (!stop.stop_requested())
+        {
+            m_stop_cv.wait_for(lock, stop, m_sync_interval, []{ return false; });
+            sync();
+        }
+    }
+};
+
+// Reads back a journal, possibly one still being appended to.
+class JournalReader
+{
+public:
+    explicit JournalReader(const std::string& path):
+        m_mapping(path, 0, false)
+    {}
+
+    // Complete records at the front of the journal.
+    auto size() const -> std::size_t
+    {
+        return m_mapping.written_count();
+    }
+
+    // Calls f(sequence, message, order_id) for each record in order after
+    // the first skip, up to the end of the log or the first record that does
+    // not decode. Returns the number passed to f.
+    template <typename F>
+    auto for_each(F&& f, std::size_t skip = 0) const -> std::size_t
+    {
+        auto message = order_protocol::GenericMessage{};
+        auto slot = skip;
+
+        for (; slot < m_mapping.capacity() && m_mapping.written(slot); slot++)
+        {
+            const auto& record = m_mapping.records()[slot];
+
+            if (!order_protocol::wire_codec::decode<order_protocol::GenericMessage>(record.frame, message))
+                break;
+
+            f(record.sequence, message, record.order_id);
+        }
+
+        return slot > skip ? slot - skip : 0;
+    }
+
+private:
+    JournalMapping m_mapping;
+};
+
+}
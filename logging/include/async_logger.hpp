@@ -0,0 +1,298 @@
+#pragma once
+
+// C
+#include <cstdio>
+
+// C++
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mpsc_queue.hpp"
+
+#ifndef EXCHANGE_LOG_LEVEL
+#define EXCHANGE_LOG_LEVEL 1
+#endif
+
+namespace exchange
+{
+
+enum class LogLevel: uint8_t
+{
+    Debug,
+    Info,
+    Warn,
+    Error,
+    Off
+};
+
+// Calls below this level compile to nothing.
+inline constexpr auto COMPILED_LOG_LEVEL = static_cast<LogLevel>(EXCHANGE_LOG_LEVEL);
+
+// A format string usable as a template argument, so each call site gets its
+// own formatter and the string itself never has to be copied.
+template <std::size_t N>
+struct LogFormat
+{
+    constexpr LogFormat(const char (&text)[N])
+    {
+        std::copy_n(text, N, data);
+    }
+
+    constexpr auto view() const -> std::string_view
+    {
+        return {data, N - 1};
+    }
+
+    char data[N];
+};
+
+// Only values that stay meaningful once copied can be logged, no pointers
+// or strings.
+template <typename T>
+concept Loggable = std::is_arithmetic_v<T> || std::is_enum_v<T>;
+
+// What a logging thread hands over: the call site's formatter and the raw
+// bytes of its arguments. Formatting happens later on the logger's thread.
+struct LogRecord
+{
+    static constexpr std::size_t ARGS_SIZE = 56;
+
+    void (*format)(const std::byte* args, std::string& out);
+    std::array<std::byte, ARGS_SIZE> args;
+};
+
+constexpr auto log_level_name(LogLevel level) -> std::string_view
+{
+    switch (level)
+    {
+    case LogLevel::Debug: return "DEBUG";
+    case LogLevel::Info: return "INFO";
+    case LogLevel::Warn: return "WARN";
+    case LogLevel::Error: return "ERROR";
+    default: return "";
+    }
+}
+
+template <typename T>
+auto printable(const T& value)
+{
+    if constexpr (std::is_enum_v<T>)
+        return std::to_underlying(value);
+    else
+        return value;
+}
+
+template <LogLevel Level, LogFormat Format, typename... Args>
+auto format_record(const std::byte* in, std::string& out) -> void
+{
+    auto values = std::tuple<Args...>{};
+
+    std::apply([&](auto&... value){
+        ((std::memcpy(&value, in, sizeof(value)), in += sizeof(value)), ...);
+    }, values);
+
+    out += std::format("[{}] ", log_level_name(Level));
+    std::apply([&](const auto&... value){
+        out += std::format(Format.view(), printable(value)...);
+    }, values);
+    out += '\n';
+}
+
+template <LogLevel Level, LogFormat Format, Loggable... Args>
+auto make_log_record(const Args&... args) -> LogRecord
+{
+    static_assert((sizeof(Args) + ... + 0) <= LogRecord::ARGS_SIZE, "Too many arguments for one log record.");
+
+    auto record = LogRecord{};
+    record.format = &format_record<Level, Format, Args...>;
+
+    auto out = record.args.data();
+    ((std::memcpy(out, &args, sizeof(Args)), out += sizeof(Args)), ...);
+
+    return record;
+}
+
+// Each logging thread gets its own lock-free ring of records, and a
+// background thread formats whatever has been queued and hands it to the
+// sink, stdout for the process wide instance. Logging never blocks, records
+// that find their ring full are dropped and counted.
+class AsyncLogger
+{
+public:
+    using Sink = std::function<void(std::string_view)>;
+
+    static constexpr std::size_t RING_CAPACITY = 4096;
+    static constexpr auto IDLE_SLEEP = std::chrono::milliseconds{1};
+
+    static auto instance() -> AsyncLogger&
+    {
+        static AsyncLogger logger{write_stdout};
+        return logger;
+    }
+
+    explicit AsyncLogger(Sink sink, std::size_t ring_capacity = RING_CAPACITY):
+        m_sink(std::move(sink)),
+        m_ring_capacity(ring_capacity),
+        m_id(next_id()),
+        m_thread([this](std::stop_token stop){ run(stop); })
+    {}
+
+    AsyncLogger(const AsyncLogger& other) = delete;
+    AsyncLogger operator=(const AsyncLogger& other) = delete;
+
+    AsyncLogger(AsyncLogger&& other) = delete;
+    AsyncLogger operator=(AsyncLogger&& other) = delete;
+
+    ~AsyncLogger()
+    {
+        m_thread.request_stop();
+        m_thread.join();
+        drain();
+    }
+
+    auto push(const LogRecord& record) -> void
+    {
+        if (!local_ring().try_push(record))
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    auto dropped() const -> uint64_t
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    using Ring = MPSCQueue<LogRecord>;
+
+    static auto write_stdout(std::string_view text) -> void
+    {
+        std::fwrite(text.data(), 1, text.size(), stdout);
+        std::fflush(stdout);
+    }
+
+    static auto next_id() -> uint64_t
+    {
+        static auto next = std::atomic<uint64_t>{0};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // A thread may log through more than one logger, so its rings are kept
+    // by logger id. Ids are never reused, unlike addresses.
+    auto local_ring() -> Ring&
+    {
+        thread_local auto rings = std::vector<std::pair<uint64_t, std::shared_ptr<Ring>>>{};
+
+        for (auto& [id, ring]: rings)
+            if (id == m_id)
+                return *ring;
+
+        return *rings.emplace_back(m_id, register_ring()).second;
+    }
+
+    auto register_ring() -> std::shared_ptr<Ring>
+    {
+        auto lock = std::lock_guard{m_rings_mutex};
+        return m_rings.emplace_back(std::make_shared<Ring>(m_ring_capacity));
+    }
+
+    auto run(std::stop_token stop) -> void
+    {
+        while (!stop.stop_requested())
+            if (!drain())
+                std::this_thread::sleep_for(IDLE_SLEEP);
+    }
+
+    // Formats and writes out every queued record, forgetting the rings of
+    // threads that have exited once they are empty. Returns the number of
+    // records written.
+    auto drain() -> std::size_t
+    {
+        auto lock = std::lock_guard{m_rings_mutex};
+        auto record = LogRecord{};
+        auto count = std::size_t{0};
+
+        m_buffer.clear();
+
+        std::erase_if(m_rings, [&](const auto& ring){
+            // Only the logger still holds the ring of an exited thread. Check
+            // that before popping, so pushes made just before exiting are
+            // written out rather than forgotten with the ring.
+            auto exited = ring.use_count() == 1;
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            while (ring->try_pop(record))
+            {
+                record.format(record.args.data(), m_buffer);
+                count++;
+            }
+
+            return exited;
+        });
+
+        if (auto dropped = m_dropped.exchange(0, std::memory_order_relaxed))
+            m_buffer += std::format("[WARN] {} log records dropped\n", dropped);
+
+        if (!m_buffer.empty())
+            m_sink(m_buffer);
+
+        return count;
+    }
+
+    Sink m_sink;
+    std::size_t m_ring_capacity;
+    uint64_t m_id;
+    std::mutex m_rings_mutex;
+    std::vector<std::shared_ptr<Ring>> m_rings;
+    std::string m_buffer;
+    std::atomic<uint64_t> m_dropped{0};
+    std::jthread m_thread;
+};
+
+template <LogLevel Level, LogFormat Format, Loggable... Args>
+auto log(const Args&... args) -> void
+{
+    if constexpr (Level >= COMPILED_LOG_LEVEL && Level != LogLevel::Off)
+        AsyncLogger::instance().push(make_log_record<Level, Format>(args...));
+}
+
+template <LogFormat Format, Loggable... Args>
+auto log_debug(const Args&... args) -> void
+{
+    log<LogLevel::Debug, Format>(args...);
+}
+
+template <LogFormat Format, Loggable... Args>
+auto log_info(const Args&... args) -> void
+{
+    log<LogLevel::Info, Format>(args...);
+}
+
+template <LogFormat Format, Loggable... Args>
+auto log_warn(const Args&... args) -> void
+{
+    log<LogLevel::Warn, Format>(args...);
+}
+
+template <LogFormat Format, Loggable... Args>
+auto log_error(const Args&... args) -> void
+{
+    log<LogLevel::Error, Format>(args...);
+}
+
+}
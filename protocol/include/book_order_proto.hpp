@@ -1,23 +1,33 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
 namespace order_protocol
 {
 
 using PriceType = size_t;
 using VolumeType = size_t;
 using OrderIDType = size_t;
+using InstrumentIDType = size_t;
+using SequenceType = size_t;
 
-enum class MessageTypeID
+enum class MessageTypeID: uint8_t
 {
     LIMIT,
     FOK,
     CANCEL,
     LIM_RESP,
     FOK_RESP,
-    CAN_RESP
+    CAN_RESP,
+    EXEC_REPORT,
+    AUCTION,
+    REJECT
 };
 
-enum class Side
+enum class Side: uint8_t
 {
     BUY,
     SELL
@@ -40,6 +50,7 @@ struct CancelDetails
 struct LimitResponseDetails
 {
     bool filled;
+    // Zero when the book rejected the order's price.
     OrderIDType order_id;
 };
 
@@ -53,16 +64,142 @@ struct CancelResponseDetails
     bool cancelled;
 };
 
+// Sent unprompted to the session that placed a resting order whenever some
+// of it trades, with sequence zero. remaining is zero once it has filled.
+struct ExecutionReportDetails
+{
+    OrderIDType order_id;
+    VolumeType volume;
+    PriceType price;
+    VolumeType remaining;
+};
+
+// Uncrosses an instrument trading in call auctions. Raised by the exchange
+// itself on the instrument's schedule and journalled like any other message,
+// its response carries the clearing price and the volume traded.
+struct AuctionDetails
+{
+    PriceType price;
+    VolumeType volume;
+};
+
+// Answers a message of a type clients may not send, see is_client_request().
+struct RejectDetails
+{
+    MessageTypeID type;
+};
+
 struct GenericMessage
 {
     MessageTypeID message_type;
+    InstrumentIDType instrument_id;
+    // Chosen by the client and echoed back in the response, so that
+    // requests can be pipelined on one connection.
+    SequenceType sequence;
 
     union { LimitDetails lim;
             FOKDetails fok;
             CancelDetails can;
             LimitResponseDetails lresp;
             FOKResponseDetails fresp;
-            CancelResponseDetails cresp; } details;
+            CancelResponseDetails cresp;
+            ExecutionReportDetails exec;
+            AuctionDetails auction;
+            RejectDetails reject; } details;
+};
+
+inline constexpr std::size_t MESSAGE_TYPE_COUNT = static_cast<std::size_t>(MessageTypeID::REJECT) + 1;
+
+// Orders and cancels. Everything else is sent by the exchange, AUCTION
+// included, as only its own schedule may uncross a book.
+inline constexpr auto is_client_request(MessageTypeID type) -> bool
+{
+    return type == MessageTypeID::LIMIT || type == MessageTypeID::FOK || type == MessageTypeID::CANCEL;
+}
+
+inline auto rejection(const GenericMessage& message) -> GenericMessage
+{
+    auto response = GenericMessage{};
+    response.message_type = MessageTypeID::REJECT;
+    response.instrument_id = message.instrument_id;
+    response.sequence = message.sequence;
+    response.details.reject = {message.message_type};
+    return response;
+}
+
+template <MessageTypeID Type>
+using message_tag = std::integral_constant<MessageTypeID, Type>;
+
+// The member of GenericMessage::details carrying each message type's fields.
+template <MessageTypeID Type>
+struct message_details;
+
+template <>
+struct message_details<MessageTypeID::LIMIT>
+{
+    static auto get(const GenericMessage& message) -> const LimitDetails& { return message.details.lim; }
 };
 
+template <>
+struct message_details<MessageTypeID::FOK>
+{
+    static auto get(const GenericMessage& message) -> const FOKDetails& { return message.details.fok; }
+};
+
+template <>
+struct message_details<MessageTypeID::CANCEL>
+{
+    static auto get(const GenericMessage& message) -> const CancelDetails& { return message.details.can; }
+};
+
+template <>
+struct message_details<MessageTypeID::LIM_RESP>
+{
+    static auto get(const GenericMessage& message) -> const LimitResponseDetails& { return message.details.lresp; }
+};
+
+template <>
+struct message_details<MessageTypeID::FOK_RESP>
+{
+    static auto get(const GenericMessage& message) -> const FOKResponseDetails& { return message.details.fresp; }
+};
+
+template <>
+struct message_details<MessageTypeID::CAN_RESP>
+{
+    static auto get(const GenericMessage& message) -> const CancelResponseDetails& { return message.details.cresp; }
+};
+
+template <>
+struct message_details<MessageTypeID::EXEC_REPORT>
+{
+    static auto get(const GenericMessage& message) -> const ExecutionReportDetails& { return message.details.exec; }
+};
+
+template <>
+struct message_details<MessageTypeID::AUCTION>
+{
+    static auto get(const GenericMessage& message) -> const AuctionDetails& { return message.details.auction; }
+};
+
+template <>
+struct message_details<MessageTypeID::REJECT>
+{
+    static auto get(const GenericMessage& message) -> const RejectDetails& { return message.details.reject; }
+};
+
+// Calls f(message_tag<Type>{}, details) for the type of message, so each
+// type's handling is chosen by overload at compile time and the switch over
+// types is generated. Returns false for an unknown type.
+template <typename F>
+inline auto visit_message(const GenericMessage& message, F&& f) -> bool
+{
+    return [&]<std::size_t... I>(std::index_sequence<I...>){
+        return ((message.message_type == static_cast<MessageTypeID>(I) ?
+                    (f(message_tag<static_cast<MessageTypeID>(I)>{},
+                       message_details<static_cast<MessageTypeID>(I)>::get(message)), true) :
+                    false) || ...);
+    }(std::make_index_sequence<MESSAGE_TYPE_COUNT>{});
+}
+
 }
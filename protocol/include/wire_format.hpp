@@ -0,0 +1,225 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <tuple>
+#include <type_traits>
+
+#include "book_order_proto.hpp"
+
+namespace order_protocol
+{
+
+// Compact little-endian encoding of GenericMessage. Every frame starts with
+//
+//     u8 version | u8 message type | u16 frame length | u32 sequence | u32 instrument
+//
+// followed by a body whose layout is fixed per message type below. Decoders
+// accept frames longer than they expect and skip the excess, so fields can be
+// appended within a version without breaking older peers.
+namespace wire
+{
+
+inline constexpr uint8_t VERSION = 1;
+
+struct header
+{
+    uint8_t version;
+    MessageTypeID type;
+    uint16_t length;
+    uint32_t sequence;
+    uint32_t instrument;
+};
+
+inline constexpr std::size_t HEADER_SIZE = 12;
+
+template <typename WireType>
+inline auto put(std::byte* out, WireType value) -> std::byte*
+{
+    if constexpr (std::endian::native == std::endian::big && sizeof(WireType) > 1)
+        value = std::byteswap(value);
+
+    std::memcpy(out, &value, sizeof(WireType));
+    return out + sizeof(WireType);
+}
+
+template <typename WireType>
+inline auto get(const std::byte*& in) -> WireType
+{
+    auto value = WireType{};
+    std::memcpy(&value, in, sizeof(WireType));
+    in += sizeof(WireType);
+
+    if constexpr (std::endian::native == std::endian::big && sizeof(WireType) > 1)
+        value = std::byteswap(value);
+
+    return value;
+}
+
+// One field of a message body: which member of the details struct it
+// carries, and the integer type it travels as.
+template <auto Member, typename WireType>
+struct field
+{
+    using wire_type = WireType;
+    static constexpr auto member = Member;
+};
+
+// Body layout of one message type, Details selects its member of the
+// GenericMessage details union. Encoding and decoding are both generated from
+// the field list.
+template <MessageTypeID Type, auto Details, typename... Fields>
+struct layout
+{
+    static constexpr MessageTypeID type = Type;
+    static constexpr std::size_t body_size = (sizeof(typename Fields::wire_type) + ... + 0);
+
+    static auto encode(const GenericMessage& message, std::byte* out) -> std::byte*
+    {
+        auto& details = message.details.*Details;
+        ((out = put(out, static_cast<typename Fields::wire_type>(details.*Fields::member))), ...);
+        return out;
+    }
+
+    static auto decode(const std::byte* in, GenericMessage& message) -> void
+    {
+        auto& details = message.details.*Details;
+        ((details.*Fields::member =
+            static_cast<std::remove_cvref_t<decltype(details.*Fields::member)>>(
+                get<typename Fields::wire_type>(in))), ...);
+    }
+};
+
+using details_type = decltype(GenericMessage::details);
+
+using layouts = std::tuple<
+    layout<MessageTypeID::LIMIT, &details_type::lim,
+           field<&LimitDetails::price, uint32_t>,
+           field<&LimitDetails::volume, uint32_t>,
+           field<&LimitDetails::side, uint8_t>>,
+    layout<MessageTypeID::FOK, &details_type::fok,
+           field<&FOKDetails::price, uint32_t>,
+           field<&FOKDetails::volume, uint32_t>,
+           field<&FOKDetails::side, uint8_t>>,
+    layout<MessageTypeID::CANCEL, &details_type::can,
+           field<&CancelDetails::order_id, uint64_t>>,
+    layout<MessageTypeID::LIM_RESP, &details_type::lresp,
+           field<&LimitResponseDetails::filled, uint8_t>,
+           field<&LimitResponseDetails::order_id, uint64_t>>,
+    layout<MessageTypeID::FOK_RESP, &details_type::fresp,
+           field<&FOKResponseDetails::filled, uint8_t>>,
+    layout<MessageTypeID::CAN_RESP, &details_type::cresp,
+           field<&CancelResponseDetails::cancelled, uint8_t>>,
+    layout<MessageTypeID::EXEC_REPORT, &details_type::exec,
+           field<&ExecutionReportDetails::order_id, uint64_t>,
+           field<&ExecutionReportDetails::volume, uint32_t>,
+           field<&ExecutionReportDetails::price, uint32_t>,
+           field<&ExecutionReportDetails::remaining, uint32_t>>,
+    layout<MessageTypeID::AUCTION, &details_type::auction,
+           field<&AuctionDetails::price, uint32_t>,
+           field<&AuctionDetails::volume, uint64_t>>,
+    layout<MessageTypeID::REJECT, &details_type::reject,
+           field<&RejectDetails::type, uint8_t>>>;
+
+// Calls f.template operator()<Layout>() for the layout of type, returns false
+// if there is none.
+template <typename F>
+inline auto visit_layout(MessageTypeID type, F&& f) -> bool
+{
+    return [&]<std::size_t... I>(std::index_sequence<I...>){
+        return ((std::tuple_element_t<I, layouts>::type == type ?
+                    (f.template operator()<std::tuple_element_t<I, layouts>>(), true) :
+                    false) || ...);
+    }(std::make_index_sequence<std::tuple_size_v<layouts>>{});
+}
+
+inline constexpr std::size_t MAX_FRAME_SIZE = []<std::size_t... I>(std::index_sequence<I...>){
+    return HEADER_SIZE + std::max({std::tuple_element_t<I, layouts>::body_size...});
+}(std::make_index_sequence<std::tuple_size_v<layouts>>{});
+
+}
+
+// Codec used by the socket transports to put GenericMessage on the wire.
+struct wire_codec
+{
+    template <typename T>
+    static constexpr std::size_t max_frame_size = wire::MAX_FRAME_SIZE;
+
+    // Length of the frame at the front of buffered, or 0 if more bytes are
+    // needed to tell.
+    template <typename T>
+    static auto frame_size(std::span<const std::byte> buffered) -> std::size_t
+    {
+        if (buffered.size() < wire::HEADER_SIZE)
+            return 0;
+
+        auto in = buffered.data() + 2;
+        // A length shorter than the header is malformed, report a header
+        // sized frame so that decode() rejects it rather than waiting forever.
+        auto length = std::max<std::size_t>(wire::get<uint16_t>(in), wire::HEADER_SIZE);
+
+        return buffered.size() < length ? 0 : length;
+    }
+
+    template <typename T>
+    static auto encode(const GenericMessage& message, std::byte* out) -> std::size_t
+    {
+        auto begin = out;
+        auto body = out + wire::HEADER_SIZE;
+
+        wire::visit_layout(message.message_type, [&]<typename Layout>(){
+            body = Layout::encode(message, body);
+        });
+
+        out = wire::put(out, wire::VERSION);
+        out = wire::put(out, static_cast<uint8_t>(message.message_type));
+        out = wire::put(out, static_cast<uint16_t>(body - begin));
+        out = wire::put(out, static_cast<uint32_t>(message.sequence));
+        out = wire::put(out, static_cast<uint32_t>(message.instrument_id));
+
+        return body - begin;
+    }
+
+    // Decodes one whole frame, returns false if it is malformed or from an
+    // incompatible protocol version.
+    template <typename T>
+    static auto decode(std::span<const std::byte> frame, GenericMessage& message) -> bool
+    {
+        if (frame.size() < wire::HEADER_SIZE)
+            return false;
+
+        auto in = frame.data();
+        auto header = wire::header{};
+        header.version = wire::get<uint8_t>(in);
+        header.type = static_cast<MessageTypeID>(wire::get<uint8_t>(in));
+        header.length = wire::get<uint16_t>(in);
+        header.sequence = wire::get<uint32_t>(in);
+        header.instrument = wire::get<uint32_t>(in);
+
+        if (header.version != wire::VERSION)
+            return false;
+
+        message = GenericMessage{};
+        message.message_type = header.type;
+        message.sequence = header.sequence;
+        message.instrument_id = header.instrument;
+
+        auto ok = false;
+
+        wire::visit_layout(header.type, [&]<typename Layout>(){
+            if (frame.size() < wire::HEADER_SIZE + Layout::body_size)
+                return;
+
+            Layout::decode(in, message);
+            ok = true;
+        });
+
+        return ok;
+    }
+};
+
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+// C++
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <unordered_map>
+#include <vector>
+
+#include "book.hpp"
+#include "fill_event.hpp"
+#include "patient_agent.hpp"
+
+namespace exchange
+{
+
+// Totals of the fills a book reports as it matches.
+struct FillTally
+{
+    std::size_t fills = 0;
+    uint64_t volume = 0;
+    uint64_t notional = 0;
+
+    auto on_fill(const fill_event& fill) -> void
+    {
+        fills++;
+        volume += fill.size;
+        notional += static_cast<uint64_t>(fill.size) * fill.price;
+    }
+};
+
+struct SimulationConfig
+{
+    std::size_t agents = 1;
+    std::size_t steps = 1'000'000;
+    uint64_t seed = 1;
+    double placement_rate = 0.4;
+    double cancellation_rate = 0.4;
+    std::size_t order_size = 10;
+};
+
+struct SimulationReport
+{
+    std::size_t steps = 0;
+    // Event driven runs only.
+    std::size_t events = 0;
+    std::chrono::nanoseconds simulated{0};
+    std::size_t orders_placed = 0;
+    std::size_t filled_immediately = 0;
+    std::size_t cancels_attempted = 0;
+    std::size_t cancels_succeeded = 0;
+    FillTally fills;
+    std::chrono::nanoseconds elapsed{0};
+};
+
+// One Book that PatientAgents trade on directly in process: their
+// callbacks call the book, with no serialisation, and every order and
+// cancel is counted. Fills against an agent's resting orders are passed
+// straight back to it, as the exchange reports them to its sessions.
+template <typename Backend = default_backend>
+class BookVenue
+{
+public:
+    using BookType = BasicBook<Backend, FillTally>;
+
+    static constexpr std::size_t BOOK_CAPACITY = 64 * 1024;
+
+    BookVenue():
+        m_book(BOOK_CAPACITY)
+    {}
+
+    BookVenue(const BookVenue& other) = delete;
+    BookVenue operator=(const BookVenue& other) = delete;
+
+    BookVenue(BookVenue&& other) = delete;
+    BookVenue operator=(BookVenue&& other) = delete;
+
+    // The agent must outlive the venue's use of it.
+    auto connect(PatientAgent& agent) -> void
+    {
+        agent.post_place_callback([this, &agent](auto side, auto size, auto price){
+            return this->place(agent, side, size, price);
+        });
+        agent.post_cancel_callback([this](auto id){
+            return this->cancel(id);
+        });
+    }
+
+    auto book() -> BookType&
+    {
+        return m_book;
+    }
+
+    auto report() -> SimulationReport&
+    {
+        return m_report;
+    }
+
+    // Brings the report's fill totals up to date with the book.
+    auto tally() -> SimulationReport&
+    {
+        m_report.fills = m_book.listener();
+        return m_report;
+    }
+
+private:
+    using OutcomeType = std::expected<PatientAgent::OrderIDType, PatientAgent::PlaceOutcome>;
+
+    BookType m_book;
+    SimulationReport m_report;
+    std::unordered_map<typename BookType::OrderIDType, PatientAgent*> m_owners;
+
+    auto place(PatientAgent& agent, PatientAgent::Side side, std::size_t size, std::size_t price) -> OutcomeType
+    {
+        m_report.orders_placed++;
+
+        auto id = side == PatientAgent::Side::BUY ?
+                        m_book.limit_buy(size, price) :
+                        m_book.limit_sell(size, price);
+
+        for (const auto& fill: m_book.fills())
+        {
+            auto it = m_owners.find(fill.resting_id);
+
+            if (it == m_owners.end())
+                continue;
+
+            it->second->on_execution(fill.resting_id, fill.resting_remaining);
+
+            if (!fill.resting_remaining)
+                m_owners.erase(it);
+        }
+
+        if (id == BookType::FILLED)
+        {
+            m_report.filled_immediately++;
+            return std::unexpected(PatientAgent::PlaceOutcome::FILLED_IMMEDIATELY);
+        }
+
+        if (id == BookType::REJECTED)
+            return std::unexpected(PatientAgent::PlaceOutcome::FAILED);
+
+        m_owners.insert_or_assign(id, &agent);
+
+        return {id};
+    }
+
+    auto cancel(PatientAgent::OrderIDType id) -> bool
+    {
+        m_report.cancels_attempted++;
+
+        auto cancelled = m_book.cancel_order(id);
+        m_report.cancels_succeeded += cancelled;
+
+        if (cancelled)
+            m_owners.erase(id);
+
+        return cancelled;
+    }
+};
+
+// Agent i is seeded from (seed, i), so a config always replays the same run.
+inline auto agent_seed(uint64_t seed, std::size_t agent) -> uint64_t
+{
+    return seed * 1'000'003 + agent;
+}
+
+// Steps PatientAgents against a BookVenue as fast as they can act, with no
+// waiting between steps.
+template <typename Backend = default_backend>
+class BookSimulation
+{
+public:
+    using BookType = typename BookVenue<Backend>::BookType;
+
+    explicit BookSimulation(const SimulationConfig& config):
+        m_config(config)
+    {
+        m_agents.reserve(config.agents);
+
+        for (auto i = std::size_t{0}; i < config.agents; i++)
+            m_venue.connect(m_agents.emplace_back(config.placement_rate,
+                                                  config.cancellation_rate,
+                                                  config.order_size,
+                                                  agent_seed(config.seed, i)));
+    }
+
+    BookSimulation(const BookSimulation& other) = delete;
+    BookSimulation operator=(const BookSimulation& other) = delete;
+
+    BookSimulation(BookSimulation&& other) = delete;
+    BookSimulation operator=(BookSimulation&& other) = delete;
+
+    // Lets every agent act once, in order. Returns false if one failed.
+    auto step() -> bool
+    {
+        m_venue.report().steps++;
+
+        for (auto& agent: m_agents)
+            if (!agent.act())
+                return false;
+
+        return true;
+    }
+
+    // Runs the configured number of steps, or until an agent fails.
+    auto run() -> const SimulationReport&
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        while (m_venue.report().steps < m_config.steps && step())
+        {}
+
+        auto& report = m_venue.tally();
+        report.elapsed += std::chrono::steady_clock::now() - start;
+
+        return report;
+    }
+
+    auto report() -> const SimulationReport&
+    {
+        return m_venue.tally();
+    }
+
+    auto book() -> BookType&
+    {
+        return m_venue.book();
+    }
+
+private:
+    SimulationConfig m_config;
+    BookVenue<Backend> m_venue;
+    std::vector<PatientAgent> m_agents;
+};
+
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+// C++
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+namespace exchange
+{
+
+// Named columns of equal length, written out column by column so that a
+// reader can load any one metric without scanning the rest. The file is
+// little-endian:
+//
+//     "MMCOLS1\0" | u64 rows | u64 columns
+//     per column:  u16 name length | name | u8 type (0 u64, 1 f64)
+//     per column:  rows values of 8 bytes each
+class ColumnarTable
+{
+public:
+    using ColumnType = std::variant<std::vector<uint64_t>, std::vector<double>>;
+
+    static constexpr std::array<char, 8> MAGIC = {'M', 'M', 'C', 'O', 'L', 'S', '1', '\0'};
+
+    auto u64_column(std::string_view name) -> std::vector<uint64_t>&
+    {
+        return std::get<std::vector<uint64_t>>(column(name, ColumnType{std::vector<uint64_t>{}}));
+    }
+
+    auto f64_column(std::string_view name) -> std::vector<double>&
+    {
+        return std::get<std::vector<double>>(column(name, ColumnType{std::vector<double>{}}));
+    }
+
+    auto find(std::string_view name) const -> const ColumnType*
+    {
+        for (const auto& [column_name, values]: m_columns)
+            if (column_name == name)
+                return &values;
+
+        return nullptr;
+    }
+
+    auto rows() const -> std::size_t
+    {
+        if (m_columns.empty())
+            return 0;
+
+        return std::visit([](const auto& values){ return values.size(); }, m_columns.front().second);
+    }
+
+    auto columns() const -> std::size_t
+    {
+        return m_columns.size();
+    }
+
+    // Returns false if the file could not be written or the columns differ
+    // in length.
+    auto write(const std::string& path) const -> bool
+    {
+        for (const auto& [name, values]: m_columns)
+            if (std::visit([](const auto& v){ return v.size(); }, values) != rows())
+                return false;
+
+        auto out = std::ofstream{path, std::ios::binary | std::ios::trunc};
+
+        out.write(MAGIC.data(), MAGIC.size());
+        put(out, static_cast<uint64_t>(rows()));
+        put(out, static_cast<uint64_t>(columns()));
+
+        for (const auto& [name, values]: m_columns)
+        {
+            put(out, static_cast<uint16_t>(name.size()));
+            out.write(name.data(), name.size());
+            put(out, static_cast<uint8_t>(values.index()));
+        }
+
+        for (const auto& [name, values]: m_columns)
+            std::visit([&](const auto& v){
+                for (auto value: v)
+                    put(out, value);
+            }, values);
+
+        return static_cast<bool>(out);
+    }
+
+    static auto read(const std::string& path) -> std::optional<ColumnarTable>
+    {
+        auto in = std::ifstream{path, std::ios::binary};
+        auto magic = std::array<char, 8>{};
+
+        if (!in.read(magic.data(), magic.size()) || magic != MAGIC)
+            return std::nullopt;
+
+        auto rows = get<uint64_t>(in);
+        auto count = get<uint64_t>(in);
+        auto table = ColumnarTable{};
+        auto types = std::vector<uint8_t>{};
+
+        for (auto i = uint64_t{0}; i < count && in; i++)
+        {
+            auto name = std::string(get<uint16_t>(in), '\0');
+            in.read(name.data(), name.size());
+            types.push_back(get<uint8_t>(in));
+
+            if (types.back() == 0)
+                table.u64_column(name);
+            else if (types.back() == 1)
+                table.f64_column(name);
+            else
+                return std::nullopt;
+
+            // A repeated name would leave fewer columns than the file lists.
+            if (table.columns() != types.size())
+                return std::nullopt;
+        }
+
+        for (auto i = uint64_t{0}; i < count && in; i++)
+            std::visit([&](auto& v){
+                using ValueType = typename std::remove_cvref_t<decltype(v)>::value_type;
+
+                // rows comes from the file, so stop as soon as it runs out.
+                for (auto row = uint64_t{0}; row < rows && in; row++)
+                    v.push_back(get<ValueType>(in));
+            }, table.m_columns[i].second);
+
+        if (!in)
+            return std::nullopt;
+
+        return table;
+    }
+
+private:
+    std::vector<std::pair<std::string, ColumnType>> m_columns;
+
+    auto column(std::string_view name, ColumnType&& empty) -> ColumnType&
+    {
+        for (auto& [column_name, values]: m_columns)
+            if (column_name == name)
+                return values;
+
+        return m_columns.emplace_back(std::string{name}, std::move(empty)).second;
+    }
+
+    template <typename T>
+    static auto put(std::ostream& out, T value) -> void
+    {
+        auto bits = std::bit_cast<std::array<char, sizeof(T)>>(value);
+
+        if constexpr (std::endian::native == std::endian::big)
+            std::reverse(bits.begin(), bits.end());
+
+        out.write(bits.data(), bits.size());
+    }
+
+    template <typename T>
+    static auto get(std::istream& in) -> T
+    {
+        auto bits = std::array<char, sizeof(T)>{};
+        in.read(bits.data(), bits.size());
+
+        if constexpr (std::endian::native == std::endian::big)
+            std::reverse(bits.begin(), bits.end());
+
+        return std::bit_cast<T>(bits);
+    }
+};
+
+}
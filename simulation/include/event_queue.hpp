@@ -0,0 +1,95 @@
+#pragma once
+
+// C++
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace exchange
+{
+
+// Priority queue for discrete-event simulation, keyed by integer virtual
+// time (a radix heap). Times must never go backwards: every push must be at
+// or after the time last popped. Events are bucketed by the highest bit in
+// which their time differs from the last popped time, and a pop only ever
+// redistributes the lowest non-empty bucket into lower ones, so each event
+// is moved at most 64 times and pushes are O(1). Events due at the same
+// time come out in a fixed but unspecified order.
+template <typename T>
+class RadixEventQueue
+{
+public:
+    using TimeType = uint64_t;
+
+    auto push(TimeType time, const T& value) -> void
+    {
+        m_buckets[bucket_of(time)].push_back({time, value});
+        m_size++;
+    }
+
+    // The queue must not be empty.
+    auto pop() -> std::pair<TimeType, T>
+    {
+        if (m_buckets[0].empty())
+            refill();
+
+        auto event = m_buckets[0].back();
+        m_buckets[0].pop_back();
+        m_size--;
+
+        return event;
+    }
+
+    auto empty() const -> bool
+    {
+        return !m_size;
+    }
+
+    auto size() const -> std::size_t
+    {
+        return m_size;
+    }
+
+    auto last_popped() const -> TimeType
+    {
+        return m_last;
+    }
+
+private:
+    using EventType = std::pair<TimeType, T>;
+
+    std::array<std::vector<EventType>, 65> m_buckets;
+    TimeType m_last = 0;
+    std::size_t m_size = 0;
+
+    auto bucket_of(TimeType time) const -> std::size_t
+    {
+        return std::bit_width(time ^ m_last);
+    }
+
+    // Advances to the earliest time in the lowest non-empty bucket and
+    // spreads that bucket over the ones below it.
+    auto refill() -> void
+    {
+        auto i = std::size_t{1};
+
+        while (m_buckets[i].empty())
+            i++;
+
+        auto& bucket = m_buckets[i];
+        m_last = bucket.front().first;
+
+        for (const auto& event: bucket)
+            m_last = std::min(m_last, event.first);
+
+        for (const auto& event: bucket)
+            m_buckets[bucket_of(event.first)].push_back(event);
+
+        bucket.clear();
+    }
+};
+
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+// C++
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "book_simulation.hpp"
+#include "event_queue.hpp"
+#include "patient_agent.hpp"
+
+namespace exchange
+{
+
+struct EventSimulationConfig
+{
+    std::size_t agents = 100'000;
+    // Virtual time to simulate, agents' rates are per virtual second.
+    std::chrono::nanoseconds duration = std::chrono::seconds{10};
+    uint64_t seed = 1;
+    double placement_rate = 0.4;
+    double cancellation_rate = 0.4;
+    std::size_t order_size = 10;
+};
+
+// Discrete-event run of PatientAgents against a BookVenue. Each agent has
+// exactly one pending action in the event queue, due after an exponential
+// inter-arrival time drawn from its own generator. The clock jumps straight
+// from one action to the next, so wall clock time goes on acting and
+// matching only, however sparse the actions are.
+template <typename Backend = default_backend>
+class EventSimulation
+{
+public:
+    using BookType = typename BookVenue<Backend>::BookType;
+    using TimeType = typename RadixEventQueue<uint32_t>::TimeType;
+
+    explicit EventSimulation(const EventSimulationConfig& config):
+        m_config(config)
+    {
+        m_agents.reserve(config.agents);
+
+        for (auto i = std::size_t{0}; i < config.agents; i++)
+        {
+            auto& agent = m_agents.emplace_back(config.placement_rate,
+                                                config.cancellation_rate,
+                                                config.order_size,
+                                                agent_seed(config.seed, i));
+            m_venue.connect(agent);
+            schedule(static_cast<uint32_t>(i), 0);
+        }
+    }
+
+    EventSimulation(const EventSimulation& other) = delete;
+    EventSimulation operator=(const EventSimulation& other) = delete;
+
+    EventSimulation(EventSimulation&& other) = delete;
+    EventSimulation operator=(EventSimulation&& other) = delete;
+
+    // Runs every action due within the configured duration, or until an
+    // agent fails.
+    auto run() -> const SimulationReport&
+    {
+        return run(m_config.duration);
+    }
+
+    // Runs every action due up to virtual time until, carrying on from
+    // where an earlier run stopped.
+    auto run(std::chrono::nanoseconds until) -> const SimulationReport&
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto end = static_cast<TimeType>(until.count());
+        auto& report = m_venue.report();
+
+        while (!m_events.empty())
+        {
+            auto [time, agent] = m_events.pop();
+
+            // Put back for the next run, it is still the agent's only action.
+            if (time > end)
+            {
+                m_events.push(time, agent);
+                break;
+            }
+
+            report.events++;
+            report.simulated = std::chrono::nanoseconds{time};
+
+            if (!m_agents[agent].perform(m_pending[agent]))
+                break;
+
+            schedule(agent, time);
+        }
+
+        report.elapsed += std::chrono::steady_clock::now() - start;
+
+        return m_venue.tally();
+    }
+
+    auto book() -> BookType&
+    {
+        return m_venue.book();
+    }
+
+private:
+    static constexpr double TICKS_PER_SECOND = 1e9;
+
+    EventSimulationConfig m_config;
+    BookVenue<Backend> m_venue;
+    std::vector<PatientAgent> m_agents;
+    std::vector<PatientAgent::Action> m_pending = std::vector<PatientAgent::Action>(m_config.agents);
+    RadixEventQueue<uint32_t> m_events;
+
+    auto schedule(uint32_t agent, TimeType now) -> void
+    {
+        auto [delay, action] = m_agents[agent].draw_next_action();
+        m_pending[agent] = action;
+        m_events.push(now + static_cast<TimeType>(std::llround(delay * TICKS_PER_SECOND)), agent);
+    }
+};
+
+}
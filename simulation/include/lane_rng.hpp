@@ -0,0 +1,186 @@
+#pragma once
+
+// C++
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace exchange
+{
+
+// xoshiro256** with one independent stream per lane, its state kept as four
+// arrays indexed by lane. Drawing for every lane is the same few shifts,
+// rotates and xors applied across those arrays with no dependency between
+// lanes, which compilers turn into SIMD. Lanes are seeded by splitmix64 of
+// (seed, lane), so a lane's stream does not depend on how many there are.
+class Xoshiro256Lanes
+{
+public:
+    Xoshiro256Lanes(std::size_t lanes, uint64_t seed):
+        m_s0(lanes), m_s1(lanes), m_s2(lanes), m_s3(lanes)
+    {
+        for (auto lane = std::size_t{0}; lane < lanes; lane++)
+        {
+            auto state = seed ^ (lane * 0xd1b54a32d192ed03);
+            m_s0[lane] = splitmix64(state);
+            m_s1[lane] = splitmix64(state);
+            m_s2[lane] = splitmix64(state);
+            m_s3[lane] = splitmix64(state);
+        }
+    }
+
+    auto lanes() const -> std::size_t
+    {
+        return m_s0.size();
+    }
+
+    // Next 64 bits of one lane's stream.
+    auto next(std::size_t lane) -> uint64_t
+    {
+        return step(m_s0[lane], m_s1[lane], m_s2[lane], m_s3[lane]);
+    }
+
+    auto uniform(std::size_t lane) -> double
+    {
+        return to_unit(next(lane));
+    }
+
+    // Uniform integer in [0, bound), bound at least 1.
+    auto below(std::size_t lane, uint64_t bound) -> uint64_t
+    {
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(next(lane)) * bound) >> 64);
+    }
+
+    // Draws one uniform in [0, 1) for every lane, out[i] from lane i.
+    auto uniform(std::span<double> out) -> void
+    {
+        auto* __restrict s0 = m_s0.data();
+        auto* __restrict s1 = m_s1.data();
+        auto* __restrict s2 = m_s2.data();
+        auto* __restrict s3 = m_s3.data();
+        auto* __restrict values = out.data();
+
+        for (auto lane = std::size_t{0}; lane < out.size(); lane++)
+            values[lane] = to_unit(step(s0[lane], s1[lane], s2[lane], s3[lane]));
+    }
+
+    // Draws one exponential at rate for every lane.
+    auto exponential(std::span<double> out, double rate) -> void
+    {
+        uniform(out);
+
+        for (auto& value: out)
+            value = -std::log1p(-value) / rate;
+    }
+
+private:
+    std::vector<uint64_t> m_s0;
+    std::vector<uint64_t> m_s1;
+    std::vector<uint64_t> m_s2;
+    std::vector<uint64_t> m_s3;
+
+    static auto splitmix64(uint64_t& state) -> uint64_t
+    {
+        auto z = (state += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+
+    static auto step(uint64_t& s0, uint64_t& s1, uint64_t& s2, uint64_t& s3) -> uint64_t
+    {
+        auto result = std::rotl(s1 * 5, 7) * 9;
+        auto t = s1 << 17;
+
+        s2 ^= s0;
+        s3 ^= s1;
+        s1 ^= s2;
+        s0 ^= s3;
+        s2 ^= t;
+        s3 = std::rotl(s3, 45);
+
+        return result;
+    }
+
+    // Top 53 bits as a double in [0, 1).
+    static auto to_unit(uint64_t bits) -> double
+    {
+        return static_cast<double>(bits >> 11) * 0x1.0p-53;
+    }
+};
+
+// Poisson sampling by inverting a precomputed CDF. A draw counts the table
+// entries its uniform is at or above. Batches compare against the first
+// HEAD_SIZE entries with no branches, which vectorizes like the uniforms
+// feeding it, and only the rare uniforms beyond those go on to the rest of
+// the table. The table is long enough that truncating it is invisible below
+// a rate of about 10.
+class PoissonTable
+{
+public:
+    static constexpr std::size_t TABLE_SIZE = 32;
+    static constexpr std::size_t HEAD_SIZE = 8;
+
+    explicit PoissonTable(double rate)
+    {
+        auto probability = std::exp(-rate);
+        auto cumulative = probability;
+
+        for (auto k = std::size_t{0}; k < TABLE_SIZE; k++)
+        {
+            m_cdf[k] = cumulative;
+            probability *= rate / (k + 1);
+            cumulative += probability;
+        }
+    }
+
+    auto sample(double uniform) const -> unsigned
+    {
+        auto count = head_count(uniform);
+
+        if (count == HEAD_SIZE)
+            count = tail_count(uniform);
+
+        return count;
+    }
+
+    // out[i] is the count drawn from uniforms[i].
+    template <typename CountType>
+    auto sample(std::span<const double> uniforms, std::span<CountType> out) const -> void
+    {
+        for (auto i = std::size_t{0}; i < uniforms.size(); i++)
+            out[i] = static_cast<CountType>(head_count(uniforms[i]));
+
+        for (auto i = std::size_t{0}; i < uniforms.size(); i++)
+            if (out[i] == HEAD_SIZE)
+                out[i] = static_cast<CountType>(tail_count(uniforms[i]));
+    }
+
+private:
+    std::array<double, TABLE_SIZE> m_cdf;
+
+    auto head_count(double uniform) const -> unsigned
+    {
+        auto count = 0u;
+
+        for (auto k = std::size_t{0}; k < HEAD_SIZE; k++)
+            count += uniform >= m_cdf[k];
+
+        return count;
+    }
+
+    auto tail_count(double uniform) const -> unsigned
+    {
+        auto count = 0u;
+
+        for (auto bound: m_cdf)
+            count += uniform >= bound;
+
+        return count;
+    }
+};
+
+}
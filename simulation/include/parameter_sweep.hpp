@@ -0,0 +1,213 @@
+#pragma once
+
+// C++
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "book_simulation.hpp"
+#include "columnar_file.hpp"
+#include "work_stealing_pool.hpp"
+
+namespace exchange
+{
+
+// Every combination of these parameters is simulated replications times.
+struct SweepGrid
+{
+    std::vector<double> placement_rates{0.4};
+    std::vector<double> cancellation_rates{0.4};
+    std::vector<std::size_t> order_sizes{10};
+    std::size_t replications = 8;
+    std::size_t agents = 10;
+    std::size_t steps = 100'000;
+    uint64_t seed = 1;
+};
+
+struct SweepPoint
+{
+    double placement_rate;
+    double cancellation_rate;
+    std::size_t order_size;
+};
+
+// What one replication measured, sampling the book after every step.
+struct MarketStats
+{
+    // Traded volume over placed volume.
+    double fill_rate = 0;
+    // Means over the steps where both sides of the book were quoted.
+    double mean_spread = 0;
+    double mean_depth = 0;
+    // Standard deviation of the step to step log change in mid price.
+    double volatility = 0;
+    uint64_t volume = 0;
+};
+
+// Running mean and variance (Welford).
+struct RunningStats
+{
+    std::size_t count = 0;
+    double mean = 0;
+    double m2 = 0;
+
+    auto add(double value) -> void
+    {
+        count++;
+        auto delta = value - mean;
+        mean += delta / count;
+        m2 += delta * (value - mean);
+    }
+
+    auto stdev() const -> double
+    {
+        return count > 1 ? std::sqrt(m2 / (count - 1)) : 0;
+    }
+};
+
+// Splits one seed into independent streams, so that a task's random
+// numbers depend only on the task and never on which thread ran it.
+inline auto split_seed(uint64_t seed, uint64_t stream) -> uint64_t
+{
+    // splitmix64
+    auto z = seed + (stream + 1) * 0x9e3779b97f4a7c15;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+template <typename Backend = default_backend>
+auto run_replication(const SweepPoint& point,
+                     std::size_t agents,
+                     std::size_t steps,
+                     uint64_t seed) -> MarketStats
+{
+    auto config = SimulationConfig{};
+    config.agents = agents;
+    config.steps = steps;
+    config.seed = seed;
+    config.placement_rate = point.placement_rate;
+    config.cancellation_rate = point.cancellation_rate;
+    config.order_size = point.order_size;
+
+    auto simulation = BookSimulation<Backend>{config};
+    auto& book = simulation.book();
+    auto spread = RunningStats{};
+    auto depth = RunningStats{};
+    auto returns = RunningStats{};
+    auto last_mid = 0.0;
+
+    for (auto step = std::size_t{0}; step < steps && simulation.step(); step++)
+    {
+        auto bid = book.best_bid();
+        auto ask = book.best_ask();
+
+        if (!bid || !ask)
+            continue;
+
+        auto mid = (*bid + *ask) / 2.0;
+
+        spread.add(static_cast<double>(*ask) - *bid);
+        depth.add(static_cast<double>(book.bid_depth() + book.ask_depth()));
+
+        if (last_mid > 0)
+            returns.add(std::log(mid / last_mid));
+
+        last_mid = mid;
+    }
+
+    const auto& report = simulation.report();
+    auto placed = static_cast<double>(report.orders_placed * point.order_size);
+
+    return {
+        .fill_rate = placed ? report.fills.volume / placed : 0,
+        .mean_spread = spread.mean,
+        .mean_depth = depth.mean,
+        .volatility = returns.stdev(),
+        .volume = report.fills.volume
+    };
+}
+
+// Runs every replication of every grid point as its own task on a
+// work-stealing pool, each with an independent seed, then aggregates the
+// replications of each point into one row per point.
+template <typename Backend = default_backend>
+class ParameterSweep
+{
+public:
+    explicit ParameterSweep(const SweepGrid& grid):
+        m_grid(grid)
+    {
+        for (auto placement: grid.placement_rates)
+            for (auto cancellation: grid.cancellation_rates)
+                for (auto size: grid.order_sizes)
+                    m_points.push_back({placement, cancellation, size});
+    }
+
+    auto points() const -> const std::vector<SweepPoint>&
+    {
+        return m_points;
+    }
+
+    auto run(WorkStealingPool& pool) -> ColumnarTable
+    {
+        auto replications = m_grid.replications;
+        auto results = std::vector<MarketStats>(m_points.size() * replications);
+
+        pool.run(results.size(), [&](std::size_t task){
+            results[task] = run_replication<Backend>(m_points[task / replications],
+                                                     m_grid.agents,
+                                                     m_grid.steps,
+                                                     split_seed(m_grid.seed, task));
+        });
+
+        return aggregate(results);
+    }
+
+private:
+    SweepGrid m_grid;
+    std::vector<SweepPoint> m_points;
+
+    auto aggregate(const std::vector<MarketStats>& results) const -> ColumnarTable
+    {
+        auto table = ColumnarTable{};
+        auto replications = m_grid.replications;
+
+        for (auto p = std::size_t{0}; p < m_points.size(); p++)
+        {
+            auto fill_rate = RunningStats{};
+            auto spread = RunningStats{};
+            auto depth = RunningStats{};
+            auto volatility = RunningStats{};
+            auto volume = RunningStats{};
+
+            for (auto r = std::size_t{0}; r < replications; r++)
+            {
+                const auto& stats = results[p * replications + r];
+                fill_rate.add(stats.fill_rate);
+                spread.add(stats.mean_spread);
+                depth.add(stats.mean_depth);
+                volatility.add(stats.volatility);
+                volume.add(static_cast<double>(stats.volume));
+            }
+
+            table.f64_column("placement_rate").push_back(m_points[p].placement_rate);
+            table.f64_column("cancellation_rate").push_back(m_points[p].cancellation_rate);
+            table.u64_column("order_size").push_back(m_points[p].order_size);
+            table.u64_column("replications").push_back(replications);
+            table.f64_column("fill_rate_mean").push_back(fill_rate.mean);
+            table.f64_column("fill_rate_stdev").push_back(fill_rate.stdev());
+            table.f64_column("spread_mean").push_back(spread.mean);
+            table.f64_column("spread_stdev").push_back(spread.stdev());
+            table.f64_column("depth_mean").push_back(depth.mean);
+            table.f64_column("depth_stdev").push_back(depth.stdev());
+            table.f64_column("volatility_mean").push_back(volatility.mean);
+            table.f64_column("volatility_stdev").push_back(volatility.stdev());
+            table.f64_column("volume_mean").push_back(volume.mean);
+        }
+
+        return table;
+    }
+};
+
+}
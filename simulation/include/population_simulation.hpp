@@ -0,0 +1,195 @@
+#pragma once
+
+// C++
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "book.hpp"
+#include "book_simulation.hpp"
+#include "lane_rng.hpp"
+
+namespace exchange
+{
+
+// The agents of BookSimulation without an object per agent: every agent
+// follows the same PatientAgent rules, but their random streams, decisions
+// and live orders are held column by column. Each step draws every agent's
+// cancel and placement counts in two vectorized passes, then only the agents
+// that drew something touch the book.
+template <typename Backend = default_backend>
+class PopulationSimulation
+{
+public:
+    using BookType = BasicBook<Backend, FillTally>;
+    using OrderIDType = typename BookType::OrderIDType;
+
+    explicit PopulationSimulation(const SimulationConfig& config):
+        m_config(config),
+        m_book(BookVenue<Backend>::BOOK_CAPACITY),
+        m_rng(config.agents, config.seed),
+        m_placements(config.placement_rate),
+        m_cancellations(config.cancellation_rate),
+        m_uniforms(config.agents),
+        m_place_counts(config.agents),
+        m_cancel_counts(config.agents),
+        m_orders(config.agents)
+    {}
+
+    PopulationSimulation(const PopulationSimulation& other) = delete;
+    PopulationSimulation operator=(const PopulationSimulation& other) = delete;
+
+    PopulationSimulation(PopulationSimulation&& other) = delete;
+    PopulationSimulation operator=(PopulationSimulation&& other) = delete;
+
+    // Every agent cancels then places its drawn number of orders, in order.
+    auto step() -> void
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        m_rng.uniform(m_uniforms);
+        m_cancellations.sample<uint8_t>(m_uniforms, m_cancel_counts);
+        m_rng.uniform(m_uniforms);
+        m_placements.sample<uint8_t>(m_uniforms, m_place_counts);
+
+        m_decision_time += std::chrono::steady_clock::now() - start;
+        m_report.steps++;
+
+        for (auto agent = std::size_t{0}; agent < m_config.agents; agent++)
+        {
+            for (auto i = 0u; i < m_cancel_counts[agent] && !m_orders[agent].empty(); i++)
+                cancel(agent);
+
+            for (auto i = 0u; i < m_place_counts[agent]; i++)
+                place(agent);
+        }
+    }
+
+    auto run() -> const SimulationReport&
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        while (m_report.steps < m_config.steps)
+            step();
+
+        m_report.elapsed += std::chrono::steady_clock::now() - start;
+
+        return report();
+    }
+
+    auto report() -> const SimulationReport&
+    {
+        m_report.fills = m_book.listener();
+        return m_report;
+    }
+
+    // Time spent drawing decisions, a part of the elapsed time.
+    auto decision_time() const -> std::chrono::nanoseconds
+    {
+        return m_decision_time;
+    }
+
+    auto active_orders(std::size_t agent) const -> std::span<const OrderIDType>
+    {
+        return m_orders[agent];
+    }
+
+    auto book() -> BookType&
+    {
+        return m_book;
+    }
+
+private:
+    // Where a resting order sits in its agent's list.
+    struct Resting
+    {
+        uint32_t agent;
+        uint32_t slot;
+    };
+
+    SimulationConfig m_config;
+    BookType m_book;
+    SimulationReport m_report;
+    std::chrono::nanoseconds m_decision_time{0};
+
+    Xoshiro256Lanes m_rng;
+    PoissonTable m_placements;
+    PoissonTable m_cancellations;
+    std::vector<double> m_uniforms;
+    std::vector<uint8_t> m_place_counts;
+    std::vector<uint8_t> m_cancel_counts;
+
+    std::vector<std::vector<OrderIDType>> m_orders;
+    std::unordered_map<OrderIDType, Resting> m_resting;
+
+    auto place(std::size_t agent) -> void
+    {
+        // As PatientAgent: a random side, and a price log-uniform below 45.
+        static const auto log_max_price = std::log(45.0);
+
+        auto buy = m_rng.next(agent) & 1;
+        auto price = static_cast<std::size_t>(std::exp(m_rng.uniform(agent) * log_max_price));
+
+        m_report.orders_placed++;
+
+        auto id = buy ?
+                    m_book.limit_buy(m_config.order_size, price) :
+                    m_book.limit_sell(m_config.order_size, price);
+
+        for (const auto& fill: m_book.fills())
+            if (!fill.resting_remaining)
+                forget(fill.resting_id);
+
+        if (id == BookType::FILLED)
+        {
+            m_report.filled_immediately++;
+            return;
+        }
+
+        if (id == BookType::REJECTED)
+            return;
+
+        auto& orders = m_orders[agent];
+        m_resting.insert_or_assign(id, Resting{static_cast<uint32_t>(agent),
+                                               static_cast<uint32_t>(orders.size())});
+        orders.push_back(id);
+    }
+
+    auto cancel(std::size_t agent) -> void
+    {
+        auto& orders = m_orders[agent];
+        auto id = orders[m_rng.below(agent, orders.size())];
+
+        m_report.cancels_attempted++;
+        m_report.cancels_succeeded += m_book.cancel_order(id);
+
+        forget(id);
+    }
+
+    // Drops a filled or cancelled order from its agent's list by moving the
+    // agent's last order into its place.
+    auto forget(OrderIDType id) -> void
+    {
+        auto it = m_resting.find(id);
+
+        if (it == m_resting.end())
+            return;
+
+        auto [agent, slot] = it->second;
+        auto& orders = m_orders[agent];
+        m_resting.erase(it);
+
+        if (slot != orders.size() - 1)
+        {
+            orders[slot] = orders.back();
+            m_resting[orders[slot]].slot = slot;
+        }
+
+        orders.pop_back();
+    }
+};
+
+}
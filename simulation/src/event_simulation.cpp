@@ -0,0 +1,41 @@
+#include <iostream>
+#include <format>
+#include <string>
+
+#include "event_simulation.hpp"
+
+using namespace exchange;
+
+// event_simulation [agents] [virtual seconds] [seed]
+int main(int argc, const char *argv[])
+{
+    auto config = EventSimulationConfig{};
+
+    if (argc > 1)
+        config.agents = std::stoull(argv[1]);
+
+    if (argc > 2)
+        config.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::duration<double>(std::stod(argv[2])));
+
+    if (argc > 3)
+        config.seed = std::stoull(argv[3]);
+
+    auto simulation = EventSimulation<>{config};
+    const auto& report = simulation.run();
+
+    auto seconds = std::chrono::duration<double>(report.elapsed).count();
+    auto simulated = std::chrono::duration<double>(report.simulated).count();
+
+    std::cout << std::format("Agents:             {}, seed {}\n", config.agents, config.seed);
+    std::cout << std::format("Simulated:          {} s, {} events\n", simulated, report.events);
+    std::cout << std::format("Orders placed:      {}\n", report.orders_placed);
+    std::cout << std::format("Filled on arrival:  {}\n", report.filled_immediately);
+    std::cout << std::format("Cancels:            {} of {} succeeded\n", report.cancels_succeeded, report.cancels_attempted);
+    std::cout << std::format("Fills:              {}\n", report.fills.fills);
+    std::cout << std::format("Volume traded:      {}\n", report.fills.volume);
+    std::cout << std::format("Notional traded:    {}\n", report.fills.notional);
+    std::cout << std::format("Elapsed:            {} s, {} events/s\n", seconds, report.events / seconds);
+
+    return 0;
+}
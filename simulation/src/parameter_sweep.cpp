@@ -0,0 +1,94 @@
+#include <iostream>
+#include <format>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "parameter_sweep.hpp"
+
+using namespace exchange;
+
+template <typename T>
+static auto parse_list(const std::string& text) -> std::vector<T>
+{
+    auto values = std::vector<T>{};
+    auto stream = std::istringstream{text};
+
+    for (auto item = std::string{}; std::getline(stream, item, ',');)
+        values.push_back(static_cast<T>(std::stod(item)));
+
+    return values;
+}
+
+// parameter_sweep [--placement a,b,..] [--cancel a,b,..] [--size a,b,..]
+//                 [--replications n] [--agents n] [--steps n] [--seed n]
+//                 [--threads n] [--out file]
+int main(int argc, const char *argv[])
+{
+    auto grid = SweepGrid{};
+    auto threads = std::max(1u, std::thread::hardware_concurrency());
+    auto out = std::string{"sweep.mmcol"};
+
+    for (auto i = 1; i + 1 < argc; i += 2)
+    {
+        auto option = std::string{argv[i]};
+        auto value = std::string{argv[i + 1]};
+
+        if (option == "--placement")
+            grid.placement_rates = parse_list<double>(value);
+        else if (option == "--cancel")
+            grid.cancellation_rates = parse_list<double>(value);
+        else if (option == "--size")
+            grid.order_sizes = parse_list<std::size_t>(value);
+        else if (option == "--replications")
+            grid.replications = std::stoull(value);
+        else if (option == "--agents")
+            grid.agents = std::stoull(value);
+        else if (option == "--steps")
+            grid.steps = std::stoull(value);
+        else if (option == "--seed")
+            grid.seed = std::stoull(value);
+        else if (option == "--threads")
+            threads = std::stoul(value);
+        else if (option == "--out")
+            out = value;
+        else
+        {
+            std::cerr << std::format("Unknown option {}\n", option);
+            return 1;
+        }
+    }
+
+    auto sweep = ParameterSweep<>{grid};
+    auto pool = WorkStealingPool{threads};
+
+    auto start = std::chrono::steady_clock::now();
+    auto table = sweep.run(pool);
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const auto& placement = std::get<std::vector<double>>(*table.find("placement_rate"));
+    const auto& cancellation = std::get<std::vector<double>>(*table.find("cancellation_rate"));
+    const auto& size = std::get<std::vector<uint64_t>>(*table.find("order_size"));
+    const auto& fill_rate = std::get<std::vector<double>>(*table.find("fill_rate_mean"));
+    const auto& spread = std::get<std::vector<double>>(*table.find("spread_mean"));
+    const auto& depth = std::get<std::vector<double>>(*table.find("depth_mean"));
+    const auto& volatility = std::get<std::vector<double>>(*table.find("volatility_mean"));
+
+    std::cout << "placement cancel size fill_rate spread depth volatility\n";
+
+    for (auto row = std::size_t{0}; row < table.rows(); row++)
+        std::cout << std::format("{} {} {} {} {} {} {}\n",
+                                 placement[row], cancellation[row], size[row],
+                                 fill_rate[row], spread[row], depth[row], volatility[row]);
+
+    std::cout << std::format("{} points x {} replications on {} threads in {} s\n",
+                             sweep.points().size(), grid.replications, pool.thread_count(), seconds);
+
+    if (!table.write(out))
+    {
+        std::cerr << std::format("Failed to write {}\n", out);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,40 @@
+#include <iostream>
+#include <format>
+#include <string>
+
+#include "book_simulation.hpp"
+
+using namespace exchange;
+
+// patient_simulation [steps] [agents] [seed]
+int main(int argc, const char *argv[])
+{
+    auto config = SimulationConfig{};
+    config.agents = 10;
+
+    if (argc > 1)
+        config.steps = std::stoull(argv[1]);
+
+    if (argc > 2)
+        config.agents = std::stoull(argv[2]);
+
+    if (argc > 3)
+        config.seed = std::stoull(argv[3]);
+
+    auto simulation = BookSimulation<>{config};
+    const auto& report = simulation.run();
+
+    auto seconds = std::chrono::duration<double>(report.elapsed).count();
+    auto agent_steps = report.steps * config.agents;
+
+    std::cout << std::format("Steps:              {} x {} agents, seed {}\n", report.steps, config.agents, config.seed);
+    std::cout << std::format("Orders placed:      {}\n", report.orders_placed);
+    std::cout << std::format("Filled on arrival:  {}\n", report.filled_immediately);
+    std::cout << std::format("Cancels:            {} of {} succeeded\n", report.cancels_succeeded, report.cancels_attempted);
+    std::cout << std::format("Fills:              {}\n", report.fills.fills);
+    std::cout << std::format("Volume traded:      {}\n", report.fills.volume);
+    std::cout << std::format("Notional traded:    {}\n", report.fills.notional);
+    std::cout << std::format("Elapsed:            {} s, {} agent steps/s\n", seconds, agent_steps / seconds);
+
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <iostream>
+#include <format>
+#include <string>
+
+#include "population_simulation.hpp"
+
+using namespace exchange;
+
+// population_simulation [steps] [agents] [seed]
+int main(int argc, const char *argv[])
+{
+    auto config = SimulationConfig{};
+    config.agents = 100'000;
+    config.steps = 100;
+
+    if (argc > 1)
+        config.steps = std::stoull(argv[1]);
+
+    if (argc > 2)
+        config.agents = std::stoull(argv[2]);
+
+    if (argc > 3)
+        config.seed = std::stoull(argv[3]);
+
+    auto construction = std::chrono::steady_clock::now();
+    auto simulation = PopulationSimulation<>{config};
+    auto constructed = std::chrono::duration<double>(std::chrono::steady_clock::now() - construction).count();
+
+    const auto& report = simulation.run();
+
+    auto seconds = std::chrono::duration<double>(report.elapsed).count();
+    auto deciding = std::chrono::duration<double>(simulation.decision_time()).count();
+    auto agent_steps = report.steps * config.agents;
+
+    std::cout << std::format("Steps:              {} x {} agents, seed {}\n", report.steps, config.agents, config.seed);
+    std::cout << std::format("Orders placed:      {}\n", report.orders_placed);
+    std::cout << std::format("Filled on arrival:  {}\n", report.filled_immediately);
+    std::cout << std::format("Cancels:            {} of {} succeeded\n", report.cancels_succeeded, report.cancels_attempted);
+    std::cout << std::format("Fills:              {}\n", report.fills.fills);
+    std::cout << std::format("Volume traded:      {}\n", report.fills.volume);
+    std::cout << std::format("Notional traded:    {}\n", report.fills.notional);
+    std::cout << std::format("Constructed in:     {} s\n", constructed);
+    std::cout << std::format("Deciding:           {} s of {} s\n", deciding, seconds);
+    std::cout << std::format("Elapsed:            {} s, {} agent steps/s\n", seconds, agent_steps / seconds);
+
+    return 0;
+}
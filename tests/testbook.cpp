@@ -1,14 +1,18 @@
 #include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
 #include <tuple>
 
 #include "gtest/gtest.h"
 
 #include "book.hpp"
 
+template <typename BookType>
 class BasicOrderBookTest: public testing::Test
 {
 protected:
-    Book b;
+    BookType b;
 
     auto setUp()
     {
@@ -17,74 +21,78 @@ protected:
     }
 };
 
-TEST_F(BasicOrderBookTest, can_buy)
+using BookBackends = testing::Types<BasicBook<map_backend>,
+                                    BasicBook<ladder_backend<4095>>>;
+TYPED_TEST_SUITE(BasicOrderBookTest, BookBackends);
+
+TYPED_TEST(BasicOrderBookTest, can_buy)
 {
-    b.limit_buy(100, 100);
+    this->b.limit_buy(100, 100);
 }
 
-TEST_F(BasicOrderBookTest, can_sell)
+TYPED_TEST(BasicOrderBookTest, can_sell)
 {
-    b.limit_sell(100, 100);
+    this->b.limit_sell(100, 100);
 }
 
-TEST_F(BasicOrderBookTest, buy_ids_are_unique)
+TYPED_TEST(BasicOrderBookTest, buy_ids_are_unique)
 {
-    ASSERT_NE(b.limit_buy(100, 100), b.limit_buy(100, 100));
+    ASSERT_NE(this->b.limit_buy(100, 100), this->b.limit_buy(100, 100));
 }
 
-TEST_F(BasicOrderBookTest, sell_ids_are_unique)
+TYPED_TEST(BasicOrderBookTest, sell_ids_are_unique)
 {
-    ASSERT_NE(b.limit_sell(100, 100), b.limit_sell(100, 100));
+    ASSERT_NE(this->b.limit_sell(100, 100), this->b.limit_sell(100, 100));
 }
 
 
-TEST_F(BasicOrderBookTest, can_match_buy_to_sell)
+TYPED_TEST(BasicOrderBookTest, can_match_buy_to_sell)
 {
     std::vector<std::tuple<order_id, order_size, order_price>> cbs;
     auto cb = [&](order_id id, order_size s, order_price p){
         cbs.push_back({ id, s, p});
         return 0;
     };
-    b.post_order_complete_callback(std::function(cb));
+    this->b.post_order_complete_callback(std::function(cb));
 
-    auto sid = b.limit_sell(100, 100);
-    auto bid = b.limit_buy(100, 100);
+    auto sid = this->b.limit_sell(100, 100);
+    auto bid = this->b.limit_buy(100, 100);
 
     EXPECT_EQ(std::get<0>(cbs[0]), sid);
     EXPECT_EQ(bid, -1);
 }
 
-TEST_F(BasicOrderBookTest, can_match_sell_to_buy)
+TYPED_TEST(BasicOrderBookTest, can_match_sell_to_buy)
 {
     std::vector<std::tuple<order_id, order_size, order_price>> cbs;
     auto cb = [&](order_id id, order_size s, order_price p){
         cbs.push_back({ id, s, p});
         return 0;
     };
-    b.post_order_complete_callback(std::function(cb));
+    this->b.post_order_complete_callback(std::function(cb));
 
-    auto bid = b.limit_buy(100, 100);
-    auto sid = b.limit_sell(100, 100);
+    auto bid = this->b.limit_buy(100, 100);
+    auto sid = this->b.limit_sell(100, 100);
 
     EXPECT_EQ(std::get<0>(cbs[0]), bid);
     EXPECT_EQ(sid, -1);
 }
 
-TEST_F(BasicOrderBookTest, matches_best_existing_buy_to_sell)
+TYPED_TEST(BasicOrderBookTest, matches_best_existing_buy_to_sell)
 {
     std::vector<std::tuple<order_id, order_size, order_price>> cbs;
     auto cb = [&](order_id id, order_size s, order_price p){
         cbs.push_back({ id, s, p});
         return 0;
     };
-    b.post_order_complete_callback(std::function(cb));
+    this->b.post_order_complete_callback(std::function(cb));
 
-    b.limit_buy(100, 80);
-    auto bid = b.limit_buy(100, 200);
-    b.limit_buy(100, 130);
-    b.limit_buy(100, 150);
+    this->b.limit_buy(100, 80);
+    auto bid = this->b.limit_buy(100, 200);
+    this->b.limit_buy(100, 130);
+    this->b.limit_buy(100, 150);
 
-    auto sid = b.limit_sell(100, 100);
+    auto sid = this->b.limit_sell(100, 100);
 
     EXPECT_EQ(std::get<0>(cbs[0]), bid);
     EXPECT_EQ(std::get<1>(cbs[0]), 100);
@@ -92,21 +100,21 @@ TEST_F(BasicOrderBookTest, matches_best_existing_buy_to_sell)
     EXPECT_EQ(sid, -1);
 }
 
-TEST_F(BasicOrderBookTest, matches_best_existing_sell_to_buy)
+TYPED_TEST(BasicOrderBookTest, matches_best_existing_sell_to_buy)
 {
     std::vector<std::tuple<order_id, order_size, order_price>> cbs;
     auto cb = [&](order_id id, order_size s, order_price p){
         cbs.push_back({ id, s, p});
         return 0;
     };
-    b.post_order_complete_callback(std::function(cb));
+    this->b.post_order_complete_callback(std::function(cb));
 
-    b.limit_sell(100, 250);
-    auto sid = b.limit_sell(100, 100);
-    b.limit_sell(100, 1700);
-    b.limit_sell(100, 140);
+    this->b.limit_sell(100, 250);
+    auto sid = this->b.limit_sell(100, 100);
+    this->b.limit_sell(100, 1700);
+    this->b.limit_sell(100, 140);
 
-    auto bid = b.limit_buy(100, 200);
+    auto bid = this->b.limit_buy(100, 200);
 
     EXPECT_EQ(std::get<0>(cbs[0]), sid);
     EXPECT_EQ(std::get<1>(cbs[0]), 100);
@@ -114,21 +122,21 @@ TEST_F(BasicOrderBookTest, matches_best_existing_sell_to_buy)
     EXPECT_EQ(bid, -1);
 }
 
-TEST_F(BasicOrderBookTest, matches_sell_to_earliest_valid_buy)
+TYPED_TEST(BasicOrderBookTest, matches_sell_to_earliest_valid_buy)
 {
     std::vector<std::tuple<order_id, order_size, order_price>> cbs;
     auto cb = [&](order_id id, order_size s, order_price p){
         cbs.push_back({ id, s, p});
         return 0;
     };
-    b.post_order_complete_callback(std::function(cb));
+    this->b.post_order_complete_callback(std::function(cb));
 
-    b.limit_buy(100, 70);
-    auto bid = b.limit_buy(100, 100);
-    b.limit_buy(100, 100);
-    b.limit_buy(100, 80);
+    this->b.limit_buy(100, 70);
+    auto bid = this->b.limit_buy(100, 100);
+    this->b.limit_buy(100, 100);
+    this->b.limit_buy(100, 80);
 
-    auto sid = b.limit_sell(100, 100);
+    auto sid = this->b.limit_sell(100, 100);
 
     EXPECT_EQ(std::get<0>(cbs[0]), bid);
     EXPECT_EQ(std::get<1>(cbs[0]), 100);
@@ -136,21 +144,21 @@ TEST_F(BasicOrderBookTest, matches_sell_to_earliest_valid_buy)
     EXPECT_EQ(sid, -1);
 }
 
-TEST_F(BasicOrderBookTest, matches_buy_to_earliest_valid_sell)
+TYPED_TEST(BasicOrderBookTest, matches_buy_to_earliest_valid_sell)
 {
     std::vector<std::tuple<order_id, order_size, order_price>> cbs;
     auto cb = [&](order_id id, order_size s, order_price p){
         cbs.push_back({ id, s, p});
         return 0;
     };
-    b.post_order_complete_callback(std::function(cb));
+    this->b.post_order_complete_callback(std::function(cb));
 
-    b.limit_sell(100, 250);
-    auto sid = b.limit_sell(100, 100);
-    b.limit_sell(100, 100);
-    b.limit_sell(100, 140);
+    this->b.limit_sell(100, 250);
+    auto sid = this->b.limit_sell(100, 100);
+    this->b.limit_sell(100, 100);
+    this->b.limit_sell(100, 140);
 
-    auto bid = b.limit_buy(100, 200);
+    auto bid = this->b.limit_buy(100, 200);
 
     EXPECT_EQ(std::get<0>(cbs[0]), sid);
     EXPECT_EQ(std::get<1>(cbs[0]), 100);
@@ -158,35 +166,35 @@ TEST_F(BasicOrderBookTest, matches_buy_to_earliest_valid_sell)
     EXPECT_EQ(bid, -1);
 }
 
-TEST_F(BasicOrderBookTest, can_cancel_buy)
+TYPED_TEST(BasicOrderBookTest, can_cancel_buy)
 {
-    auto bid = b.limit_buy(100, 100);
-    ASSERT_TRUE(b.cancel_order(bid));
+    auto bid = this->b.limit_buy(100, 100);
+    ASSERT_TRUE(this->b.cancel_order(bid));
 }
 
-TEST_F(BasicOrderBookTest, can_cancel_sell)
+TYPED_TEST(BasicOrderBookTest, can_cancel_sell)
 {
-    auto sid = b.limit_sell(100, 100);
-    ASSERT_TRUE(b.cancel_order(sid));
+    auto sid = this->b.limit_sell(100, 100);
+    ASSERT_TRUE(this->b.cancel_order(sid));
 }
 
-TEST_F(BasicOrderBookTest, cannot_cancel_bad_id)
+TYPED_TEST(BasicOrderBookTest, cannot_cancel_bad_id)
 {
-    auto sid = b.limit_sell(100, 100);
-    ASSERT_FALSE(b.cancel_order(101));
+    auto sid = this->b.limit_sell(100, 100);
+    ASSERT_FALSE(this->b.cancel_order(101));
 }
 
-TEST_F(BasicOrderBookTest, can_fok_sell)
+TYPED_TEST(BasicOrderBookTest, can_fok_sell)
 {
     std::vector<std::tuple<order_id, order_size, order_price>> cbs;
     auto cb = [&](order_id id, order_size s, order_price p){
         cbs.push_back({ id, s, p});
         return 0;
     };
-    b.post_order_complete_callback(std::function(cb));
+    this->b.post_order_complete_callback(std::function(cb));
 
-    auto bid = b.limit_buy(100, 100);
-    auto fok_success = b.fok_sell(50, 25);
+    auto bid = this->b.limit_buy(100, 100);
+    auto fok_success = this->b.fok_sell(50, 25);
 
     EXPECT_EQ(std::get<0>(cbs[0]), bid);
     EXPECT_EQ(std::get<1>(cbs[0]), 50); // Size
@@ -195,18 +203,548 @@ TEST_F(BasicOrderBookTest, can_fok_sell)
     ASSERT_TRUE(fok_success);
 }
 
-TEST_F(BasicOrderBookTest, doesnt_fill_with_worse_price)
+TYPED_TEST(BasicOrderBookTest, doesnt_fill_with_worse_price)
 {
     std::vector<std::tuple<order_id, order_size, order_price>> cbs;
     auto cb = [&](order_id id, order_size s, order_price p){
         cbs.push_back({ id, s, p});
         return 0;
     };
-    b.post_order_complete_callback(std::function(cb));
+    this->b.post_order_complete_callback(std::function(cb));
 
-    auto bid = b.limit_buy(100, 100);
-    auto fok_success = b.fok_sell(50, 125);
+    auto bid = this->b.limit_buy(100, 100);
+    auto fok_success = this->b.fok_sell(50, 125);
 
     ASSERT_TRUE(cbs.empty());
     ASSERT_FALSE(fok_success);
 }
+
+TYPED_TEST(BasicOrderBookTest, rests_multiple_orders_at_same_price)
+{
+    auto first = this->b.limit_sell(100, 100);
+    auto second = this->b.limit_sell(100, 100);
+
+    ASSERT_TRUE(this->b.cancel_order(first));
+    ASSERT_TRUE(this->b.cancel_order(second));
+}
+
+TYPED_TEST(BasicOrderBookTest, fills_same_price_in_time_priority)
+{
+    std::vector<std::tuple<order_id, order_size, order_price>> cbs;
+    auto cb = [&](order_id id, order_size s, order_price p){
+        cbs.push_back({ id, s, p});
+        return 0;
+    };
+    this->b.post_order_complete_callback(std::function(cb));
+
+    auto first = this->b.limit_sell(100, 100);
+    auto second = this->b.limit_sell(100, 100);
+
+    auto bid = this->b.limit_buy(150, 100);
+
+    ASSERT_EQ(cbs.size(), 2);
+    EXPECT_EQ(std::get<0>(cbs[0]), first);
+    EXPECT_EQ(std::get<1>(cbs[0]), 100);
+    EXPECT_EQ(std::get<0>(cbs[1]), second);
+    EXPECT_EQ(std::get<1>(cbs[1]), 50);
+    EXPECT_EQ(bid, -1);
+}
+
+TYPED_TEST(BasicOrderBookTest, partial_fill_leaves_remainder_resting)
+{
+    std::vector<std::tuple<order_id, order_size, order_price>> cbs;
+    auto cb = [&](order_id id, order_size s, order_price p){
+        cbs.push_back({ id, s, p});
+        return 0;
+    };
+    this->b.post_order_complete_callback(std::function(cb));
+
+    auto bid = this->b.limit_buy(100, 100);
+    this->b.limit_sell(30, 100);
+    this->b.limit_sell(70, 100);
+
+    ASSERT_EQ(cbs.size(), 2);
+    EXPECT_EQ(std::get<0>(cbs[1]), bid);
+    EXPECT_EQ(std::get<1>(cbs[1]), 70);
+    ASSERT_FALSE(this->b.cancel_order(bid));
+}
+
+TEST(PriceLadderTest, rejects_resting_price_outside_range)
+{
+    auto b = BasicBook<ladder_backend<63>>{};
+    auto ask = b.limit_sell(100, 10);
+    auto in_use = b.order_pool_stats().in_use;
+
+    EXPECT_EQ(b.limit_buy(100, 64), decltype(b)::REJECTED);
+    EXPECT_TRUE(b.fills().empty());
+    EXPECT_FALSE(b.fok_buy(100, 64));
+    EXPECT_TRUE(b.fills().empty());
+
+    EXPECT_EQ(b.best_ask(), 10);
+    EXPECT_EQ(b.executable_buy(63), 100);
+    EXPECT_EQ(b.order_pool_stats().in_use, in_use);
+    EXPECT_EQ(b.limit_sell(100, 20), ask + 1);
+}
+
+TEST(PriceLadderTest, sweeps_levels_across_bitmap_words)
+{
+    auto b = BasicBook<ladder_backend<4095>>{};
+    std::vector<order_price> prices;
+    b.post_order_complete_callback([&](order_id, order_size, order_price p){
+        prices.push_back(p);
+        return 0;
+    });
+
+    b.limit_sell(10, 4000);
+    b.limit_sell(10, 5);
+    b.limit_sell(10, 700);
+    b.limit_sell(10, 64);
+
+    b.limit_buy(40, 4095);
+
+    ASSERT_EQ(prices, (std::vector<order_price>{5, 64, 700, 4000}));
+}
+
+TEST(OccupancyBitmapTest, finds_nearest_set_bits)
+{
+    auto bits = occupancy_bitmap<5000>{};
+
+    EXPECT_EQ(bits.lowest(), bits.npos);
+    EXPECT_EQ(bits.highest(), bits.npos);
+
+    bits.set(3);
+    bits.set(130);
+    bits.set(4999);
+
+    EXPECT_EQ(bits.lowest(), 3);
+    EXPECT_EQ(bits.highest(), 4999);
+    EXPECT_EQ(bits.next_after(3), 130);
+    EXPECT_EQ(bits.next_after(130), 4999);
+    EXPECT_EQ(bits.prev_before(4999), 130);
+    EXPECT_EQ(bits.prev_before(3), bits.npos);
+
+    bits.reset(130);
+
+    EXPECT_EQ(bits.next_after(3), 4999);
+    EXPECT_EQ(bits.prev_before(4999), 3);
+}
+
+TEST(OrderPoolTest, recycles_released_orders)
+{
+    auto b = Book{2};
+
+    auto first = b.limit_buy(10, 10);
+    b.limit_buy(10, 11);
+    b.cancel_order(first);
+    b.limit_buy(10, 12);
+
+    auto stats = b.order_pool_stats();
+    EXPECT_EQ(stats.capacity, 2);
+    EXPECT_EQ(stats.slabs, 1);
+    EXPECT_EQ(stats.in_use, 2);
+    EXPECT_EQ(stats.high_water_mark, 2);
+}
+
+TEST(OrderPoolTest, grows_by_slab_when_exhausted)
+{
+    auto pool = order_pool{1, 4};
+
+    auto a = pool.acquire();
+    auto b = pool.acquire();
+    pool.release(a);
+
+    auto stats = pool.get_stats();
+    EXPECT_EQ(stats.capacity, 5);
+    EXPECT_EQ(stats.slabs, 2);
+    EXPECT_EQ(stats.in_use, 1);
+    EXPECT_EQ(stats.high_water_mark, 2);
+    EXPECT_EQ(pool.acquire(), a);
+    EXPECT_NE(b, a);
+}
+
+TEST(OrderIdTest, ids_are_sequential_and_prefixed)
+{
+    auto b = Book{16, 7};
+
+    auto first = b.limit_buy(10, 10);
+    auto second = b.limit_sell(10, 20);
+
+    EXPECT_EQ(second, first + 1);
+    EXPECT_EQ(order_id_generator::prefix_of(first), 7);
+}
+
+TEST(OrderIndexTest, survives_interleaved_insert_and_erase)
+{
+    auto index = order_index{};
+    auto orders = std::vector<order>(1000);
+
+    for (auto id = order_id{1}; id <= orders.size(); id++)
+        index.insert(id, &orders[id - 1]);
+
+    for (auto id = order_id{1}; id <= orders.size(); id += 2)
+        ASSERT_EQ(index.erase(id), &orders[id - 1]);
+
+    EXPECT_EQ(index.size(), 500);
+
+    for (auto id = order_id{1}; id <= orders.size(); id++)
+        ASSERT_EQ(index.find(id), id % 2 ? nullptr : &orders[id - 1]);
+
+    EXPECT_EQ(index.erase(1), nullptr);
+}
+
+TYPED_TEST(BasicOrderBookTest, fok_fills_across_levels)
+{
+    std::vector<std::tuple<order_id, order_size, order_price>> cbs;
+    auto cb = [&](order_id id, order_size s, order_price p){
+        cbs.push_back({ id, s, p});
+        return 0;
+    };
+    this->b.post_order_complete_callback(std::function(cb));
+
+    this->b.limit_sell(30, 100);
+    this->b.limit_sell(30, 100);
+    this->b.limit_sell(30, 101);
+    this->b.limit_sell(30, 110);
+
+    ASSERT_TRUE(this->b.fok_buy(80, 101));
+    ASSERT_EQ(cbs.size(), 3);
+    EXPECT_EQ(std::get<1>(cbs[2]), 20);
+    EXPECT_EQ(std::get<2>(cbs[2]), 101);
+}
+
+TYPED_TEST(BasicOrderBookTest, failed_fok_leaves_book_untouched)
+{
+    std::vector<std::tuple<order_id, order_size, order_price>> cbs;
+    auto cb = [&](order_id id, order_size s, order_price p){
+        cbs.push_back({ id, s, p});
+        return 0;
+    };
+    this->b.post_order_complete_callback(std::function(cb));
+
+    auto sid = this->b.limit_sell(30, 100);
+    this->b.limit_sell(30, 110);
+
+    ASSERT_FALSE(this->b.fok_buy(40, 105));
+    ASSERT_FALSE(this->b.fok_buy(100, 200));
+    ASSERT_TRUE(cbs.empty());
+
+    ASSERT_TRUE(this->b.fok_buy(60, 110));
+    EXPECT_EQ(std::get<0>(cbs[0]), sid);
+    EXPECT_FALSE(this->b.fok_buy(1, 200));
+}
+
+TYPED_TEST(BasicOrderBookTest, reports_top_of_book_and_depth)
+{
+    EXPECT_FALSE(this->b.best_bid());
+    EXPECT_FALSE(this->b.best_ask());
+
+    this->b.limit_buy(10, 95);
+    this->b.limit_buy(20, 97);
+    this->b.limit_sell(30, 101);
+
+    EXPECT_EQ(this->b.best_bid(), 97);
+    EXPECT_EQ(this->b.best_ask(), 101);
+    EXPECT_EQ(this->b.bid_depth(), 30);
+    EXPECT_EQ(this->b.ask_depth(), 30);
+
+    this->b.limit_sell(25, 96);
+
+    EXPECT_EQ(this->b.best_bid(), 95);
+    EXPECT_EQ(this->b.best_ask(), 96);
+    EXPECT_EQ(this->b.bid_depth(), 10);
+    EXPECT_EQ(this->b.ask_depth(), 35);
+}
+
+TYPED_TEST(BasicOrderBookTest, restores_a_snapshot_with_priority_and_ids)
+{
+    this->b.limit_buy(10, 95);
+    auto cancelled = this->b.limit_buy(15, 97);
+    this->b.limit_buy(20, 97);
+    this->b.limit_buy(5, 97);
+    this->b.limit_sell(30, 101);
+    this->b.limit_sell(40, 103);
+    this->b.cancel_order(cancelled);
+
+    auto snapshot = std::stringstream{};
+    ASSERT_TRUE(this->b.save(snapshot));
+
+    auto restored = TypeParam{};
+    ASSERT_TRUE(restored.restore(snapshot));
+
+    EXPECT_EQ(restored.best_bid(), this->b.best_bid());
+    EXPECT_EQ(restored.best_ask(), this->b.best_ask());
+    EXPECT_EQ(restored.bid_depth(), this->b.bid_depth());
+    EXPECT_EQ(restored.ask_depth(), this->b.ask_depth());
+    EXPECT_EQ(restored.limit_sell(1, 200), this->b.limit_sell(1, 200));
+    EXPECT_FALSE(restored.cancel_order(cancelled));
+
+    // Both match the same resting orders in the same order.
+    restored.limit_sell(30, 90);
+    this->b.limit_sell(30, 90);
+    auto fills = restored.fills();
+    auto expected = this->b.fills();
+
+    ASSERT_EQ(fills.size(), expected.size());
+
+    for (auto i = std::size_t{0}; i < fills.size(); i++)
+    {
+        EXPECT_EQ(fills[i].resting_id, expected[i].resting_id);
+        EXPECT_EQ(fills[i].size, expected[i].size);
+    }
+}
+
+TYPED_TEST(BasicOrderBookTest, rejects_malformed_snapshots)
+{
+    auto garbage = std::stringstream{"not a snapshot at all, just some text"};
+    EXPECT_FALSE(this->b.restore(garbage));
+
+    // Bids listed worst price first.
+    auto header = book_snapshot_header{book_snapshot_header::MAGIC, 10, 2, 0};
+    auto orders = std::array<order_snapshot, 2>{{{1, 10, 95}, {2, 10, 97}}};
+    auto snapshot = std::stringstream{};
+    snapshot.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    snapshot.write(reinterpret_cast<const char*>(orders.data()), sizeof(orders));
+
+    EXPECT_FALSE(this->b.restore(snapshot));
+    EXPECT_FALSE(this->b.best_bid());
+    EXPECT_EQ(this->b.bid_depth(), 0);
+
+    // Counts far beyond the orders in the stream.
+    auto oversized = book_snapshot_header{book_snapshot_header::MAGIC, 10, ~uint64_t{0} / 2, ~uint64_t{0} / 2};
+    auto truncated = std::stringstream{};
+    truncated.write(reinterpret_cast<const char*>(&oversized), sizeof(oversized));
+    truncated.write(reinterpret_cast<const char*>(orders.data()), sizeof(orders));
+
+    EXPECT_FALSE(this->b.restore(truncated));
+
+    // The next id would be handed out again.
+    auto stale = book_snapshot_header{book_snapshot_header::MAGIC, 2, 2, 0};
+    auto reused = std::array<order_snapshot, 2>{{{1, 10, 97}, {2, 10, 95}}};
+    auto colliding = std::stringstream{};
+    colliding.write(reinterpret_cast<const char*>(&stale), sizeof(stale));
+    colliding.write(reinterpret_cast<const char*>(reused.data()), sizeof(reused));
+
+    EXPECT_FALSE(this->b.restore(colliding));
+    EXPECT_FALSE(this->b.best_bid());
+
+    this->b.limit_buy(10, 95);
+    auto other = std::stringstream{};
+    ASSERT_TRUE(this->b.save(other));
+    EXPECT_FALSE(this->b.restore(other));
+}
+
+TYPED_TEST(BasicOrderBookTest, call_auction_clears_at_max_volume_price)
+{
+    this->b.set_matching_mode(matching_mode::CALL_AUCTION);
+
+    auto b1 = this->b.limit_buy(10, 100);
+    auto b2 = this->b.limit_buy(20, 99);
+    this->b.limit_buy(30, 97);
+    auto s1 = this->b.limit_sell(15, 96);
+    auto s2 = this->b.limit_sell(25, 98);
+    this->b.limit_sell(20, 101);
+
+    // Nothing trades on arrival, the book is left crossed.
+    EXPECT_TRUE(this->b.fills().empty());
+    EXPECT_EQ(this->b.best_bid(), 100);
+    EXPECT_EQ(this->b.best_ask(), 96);
+
+    // 98 and 99 both trade 30 with 10 left over, the lower price wins.
+    auto result = this->b.uncross();
+    EXPECT_EQ(result.price, 98);
+    EXPECT_EQ(result.volume, 30);
+
+    auto fills = this->b.fills();
+    ASSERT_EQ(fills.size(), 4);
+    EXPECT_EQ(fills[0].resting_id, b1);
+    EXPECT_EQ(fills[1].resting_id, b2);
+    EXPECT_EQ(fills[2].resting_id, s1);
+    EXPECT_EQ(fills[3].resting_id, s2);
+    EXPECT_EQ(fills[3].size, 15);
+    EXPECT_EQ(fills[3].resting_remaining, 10);
+
+    for (const auto& fill: fills)
+        EXPECT_EQ(fill.price, 98);
+
+    EXPECT_EQ(this->b.best_bid(), 97);
+    EXPECT_EQ(this->b.best_ask(), 98);
+    EXPECT_EQ(this->b.bid_depth(), 30);
+    EXPECT_EQ(this->b.ask_depth(), 30);
+
+    EXPECT_EQ(this->b.uncross().volume, 0);
+    EXPECT_TRUE(this->b.fills().empty());
+}
+
+TYPED_TEST(BasicOrderBookTest, leaving_call_auction_uncrosses_in_time_priority)
+{
+    this->b.set_matching_mode(matching_mode::CALL_AUCTION);
+
+    auto first = this->b.limit_buy(10, 100);
+    auto second = this->b.limit_buy(10, 100);
+    this->b.limit_sell(15, 100);
+
+    EXPECT_FALSE(this->b.fok_buy(5, 100));
+    EXPECT_EQ(this->b.ask_depth(), 15);
+
+    this->b.set_matching_mode(matching_mode::CONTINUOUS);
+
+    auto fills = this->b.fills();
+    ASSERT_EQ(fills.size(), 3);
+    EXPECT_EQ(fills[0].resting_id, first);
+    EXPECT_EQ(fills[0].resting_remaining, 0);
+    EXPECT_EQ(fills[1].resting_id, second);
+    EXPECT_EQ(fills[1].size, 5);
+    EXPECT_EQ(fills[1].resting_remaining, 5);
+    EXPECT_EQ(this->b.mode(), matching_mode::CONTINUOUS);
+
+    EXPECT_EQ(this->b.limit_sell(5, 100), -1);
+    EXPECT_EQ(this->b.fills()[0].resting_id, second);
+}
+
+TEST(ClearingPriceTest, maximizes_volume_then_balance)
+{
+    // Prices ascending; demand 60 60 30 30 10, supply 15 15 40 40 40.
+    auto bids = std::array<level_volume, 5>{0, 30, 0, 20, 10};
+    auto asks = std::array<level_volume, 5>{15, 0, 25, 0, 0};
+
+    auto result = find_clearing_price(bids, asks);
+    EXPECT_EQ(result.index, 2);
+    EXPECT_EQ(result.volume, 30);
+
+    // 25 trades at either price, the second leaves nothing over.
+    auto balanced_bids = std::array<level_volume, 2>{5, 25};
+    auto balanced_asks = std::array<level_volume, 2>{25, 0};
+
+    result = find_clearing_price(balanced_bids, balanced_asks);
+    EXPECT_EQ(result.index, 1);
+    EXPECT_EQ(result.volume, 25);
+
+    EXPECT_EQ(find_clearing_price({}, {}).volume, 0);
+}
+
+// Every price's volume and imbalance worked out in full.
+auto brute_force_clearing_price(std::span<const level_volume> bids,
+                                std::span<const level_volume> asks) -> clearing_result
+{
+    auto best = clearing_result{};
+    auto best_imbalance = ~level_volume{0};
+
+    for (auto i = std::size_t{0}; i < bids.size(); i++)
+    {
+        auto demand = std::accumulate(bids.begin() + i, bids.end(), level_volume{0});
+        auto supply = std::accumulate(asks.begin(), asks.begin() + i + 1, level_volume{0});
+        auto volume = std::min(demand, supply);
+        auto imbalance = std::max(demand, supply) - volume;
+
+        if (volume > best.volume || (volume && volume == best.volume && imbalance < best_imbalance))
+        {
+            best = {i, volume};
+            best_imbalance = imbalance;
+        }
+    }
+
+    return best;
+}
+
+TEST(ClearingPriceTest, kernels_match_brute_force)
+{
+    auto rng = std::mt19937_64{7};
+    auto kernels = std::vector<clearing_kernels::kernel>{clearing_kernels::scalar, clearing_kernels::select()};
+
+    for (auto size = std::size_t{0}; size < 70; size++)
+    {
+        for (auto trial = 0; trial < 20; trial++)
+        {
+            auto bids = std::vector<level_volume>(size);
+            auto asks = std::vector<level_volume>(size);
+
+            // Few distinct volumes, many zeros, so ties are common. Bids
+            // lean to low prices and asks to high ones some of the time, to
+            // move the clearing price about.
+            auto lean = rng() % 3;
+
+            for (auto i = std::size_t{0}; i < size; i++)
+            {
+                auto low = i < size / 2;
+                bids[i] = rng() % 3 && !(lean == 1 && !low) ? 0 : 10 * (rng() % 4);
+                asks[i] = rng() % 3 && !(lean == 1 && low) ? 0 : 10 * (rng() % 4);
+            }
+
+            auto expected = brute_force_clearing_price(bids, asks);
+
+            for (auto kernel: kernels)
+            {
+                auto result = kernel(bids, asks);
+                EXPECT_EQ(result.index, expected.index) << size;
+                EXPECT_EQ(result.volume, expected.volume) << size;
+            }
+        }
+    }
+}
+
+TYPED_TEST(BasicOrderBookTest, reports_executable_volume_up_to_a_price)
+{
+    this->b.limit_sell(10, 101);
+    this->b.limit_sell(20, 102);
+    this->b.limit_sell(5, 102);
+    this->b.limit_buy(15, 99);
+    this->b.limit_buy(25, 97);
+
+    EXPECT_EQ(this->b.executable_buy(100), 0);
+    EXPECT_EQ(this->b.executable_buy(101), 10);
+    EXPECT_EQ(this->b.executable_buy(150), 35);
+    EXPECT_EQ(this->b.executable_sell(99), 15);
+    EXPECT_EQ(this->b.executable_sell(1), 40);
+    EXPECT_EQ(this->b.executable_sell(100), 0);
+}
+
+TEST(FillEventTest, records_fills_of_last_order)
+{
+    auto b = Book{};
+    auto calls = 0;
+    b.post_fill_batch_callback([&](std::span<const fill_event> fills){
+        calls++;
+        EXPECT_EQ(fills.size(), 2);
+    });
+
+    auto first = b.limit_sell(30, 100);
+    auto second = b.limit_sell(30, 101);
+    b.limit_buy(40, 105);
+
+    auto fills = b.fills();
+    ASSERT_EQ(fills.size(), 2);
+    EXPECT_EQ(fills[0].resting_id, first);
+    EXPECT_EQ(fills[0].size, 30);
+    EXPECT_EQ(fills[0].resting_remaining, 0);
+    EXPECT_EQ(fills[1].resting_id, second);
+    EXPECT_EQ(fills[1].size, 10);
+    EXPECT_EQ(fills[1].resting_remaining, 20);
+    EXPECT_EQ(fills[1].aggressor_type, order_type::LIM_BUY);
+    EXPECT_EQ(fills[1].aggressor_price, 105);
+    EXPECT_EQ(calls, 1);
+
+    b.fok_buy(100, 105);
+    EXPECT_TRUE(b.fills().empty());
+    EXPECT_EQ(calls, 1);
+}
+
+struct counting_listener
+{
+    order_size volume = 0;
+
+    auto on_fill(const fill_event& fill) -> void
+    {
+        volume += fill.size;
+    }
+};
+
+TEST(FillEventTest, invokes_listener_policy_per_fill)
+{
+    auto b = BasicBook<map_backend, counting_listener>{};
+
+    b.limit_buy(30, 100);
+    b.limit_buy(30, 99);
+    b.fok_sell(45, 99);
+
+    EXPECT_EQ(b.listener().volume, 45);
+}
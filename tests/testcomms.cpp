@@ -0,0 +1,431 @@
+#include <gtest/gtest.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "book_order_proto.hpp"
+#include "message_handler.hpp"
+#include "server.hpp"
+#include "shm_ring.hpp"
+#include "shm_transport.hpp"
+#include "socket_ops.hpp"
+#include "wire_format.hpp"
+
+using namespace exchange;
+using namespace order_protocol;
+
+namespace
+{
+
+auto limit(SequenceType sequence) -> GenericMessage
+{
+    auto message = GenericMessage{};
+    message.message_type = MessageTypeID::LIMIT;
+    message.sequence = sequence;
+    message.details.lim = {.price = 10, .volume = 5, .side = Side::BUY};
+    return message;
+}
+
+auto encode(const GenericMessage& message) -> std::vector<std::byte>
+{
+    auto frame = std::vector<std::byte>(wire::MAX_FRAME_SIZE);
+    frame.resize(wire_codec::encode<GenericMessage>(message, frame.data()));
+    return frame;
+}
+
+// Serves one event loop echoing every message back, for as long as the
+// fixture lives.
+class EventLoopTest: public ::testing::Test
+{
+protected:
+    using ServerType = UDSServer<GenericMessage, GenericMessage, wire_codec>;
+
+    EventLoopTest()
+    {
+        m_server.post_batch_response_callback([](auto messages, auto responses){
+            std::ranges::copy(messages, responses.begin());
+        });
+
+        m_loop = std::jthread{[this](std::stop_token stop){
+            m_server.start_event_loop(1, stop);
+        }};
+    }
+
+    ~EventLoopTest() override
+    {
+        if (m_client != -1)
+            close(m_client);
+    }
+
+    auto client() -> int
+    {
+        if (m_client == -1)
+        {
+            m_client = socket(AF_UNIX, SOCK_STREAM, 0);
+            EXPECT_TRUE(do_connect(m_client, "foobar"));
+        }
+
+        return m_client;
+    }
+
+    auto receive() -> std::optional<GenericMessage>
+    {
+        auto frame = std::vector<std::byte>(encode(limit(0)).size());
+        auto message = GenericMessage{};
+
+        if (!recv_all(client(), frame) || !wire_codec::decode<GenericMessage>(frame, message))
+            return std::nullopt;
+
+        return message;
+    }
+
+    ServerType m_server;
+    std::jthread m_loop;
+    int m_client = -1;
+};
+
+}
+
+TEST_F(EventLoopTest, answers_a_frame_split_across_reads)
+{
+    auto frame = encode(limit(7));
+
+    ASSERT_TRUE(send_all(client(), std::span{frame}.first(5)));
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    ASSERT_TRUE(send_all(client(), std::span{frame}.subspan(5)));
+
+    auto response = receive();
+    ASSERT_TRUE(response);
+    EXPECT_EQ(response->sequence, 7);
+}
+
+TEST_F(EventLoopTest, answers_frames_split_at_every_boundary)
+{
+    auto stream = std::vector<std::byte>{};
+
+    for (auto sequence = SequenceType{1}; sequence <= 3; sequence++)
+        std::ranges::copy(encode(limit(sequence)), std::back_inserter(stream));
+
+    // Seven bytes a time cuts headers, bodies and the gaps between frames.
+    for (auto offset = std::size_t{0}; offset < stream.size(); offset += 7)
+    {
+        auto piece = std::span{stream}.subspan(offset, std::min<std::size_t>(7, stream.size() - offset));
+        ASSERT_TRUE(send_all(client(), piece));
+        std::this_thread::sleep_for(std::chrono::milliseconds{2});
+    }
+
+    for (auto sequence = SequenceType{1}; sequence <= 3; sequence++)
+    {
+        auto response = receive();
+        ASSERT_TRUE(response);
+        EXPECT_EQ(response->sequence, sequence);
+    }
+}
+
+// A frame the size of the receive buffer followed by more, so reads cross
+// the end of the buffer while it is nearly full.
+TEST_F(EventLoopTest, answers_frames_filling_the_receive_buffer)
+{
+    auto stream = encode(limit(1));
+    stream.resize(UINT16_MAX);
+    auto length = static_cast<uint16_t>(UINT16_MAX);
+    std::memcpy(stream.data() + 2, &length, sizeof(length));
+
+    for (auto sequence = SequenceType{2}; sequence <= 64; sequence++)
+        std::ranges::copy(encode(limit(sequence)), std::back_inserter(stream));
+
+    ASSERT_TRUE(send_all(client(), stream));
+
+    for (auto sequence = SequenceType{1}; sequence <= 64; sequence++)
+    {
+        auto response = receive();
+        ASSERT_TRUE(response);
+        EXPECT_EQ(response->sequence, sequence);
+    }
+}
+
+TEST_F(EventLoopTest, closes_connections_sending_malformed_frames)
+{
+    auto frame = encode(limit(1));
+    frame[0] = std::byte{wire::VERSION + 1};
+
+    ASSERT_TRUE(send_all(client(), frame));
+
+    auto byte = std::byte{};
+    EXPECT_EQ(recv(client(), &byte, 1, 0), 0);
+}
+
+namespace
+{
+
+// Connected pair of stream sockets, closed when it goes.
+struct SocketPair
+{
+    SocketPair()
+    {
+        EXPECT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    }
+
+    ~SocketPair()
+    {
+        for (auto fd: fds)
+            if (fd != -1)
+                close(fd);
+    }
+
+    auto close_end(int end) -> void
+    {
+        close(fds[end]);
+        fds[end] = -1;
+    }
+
+    int fds[2] = {-1, -1};
+};
+
+}
+
+TEST(SocketOpsTest, send_all_writes_past_the_socket_buffer)
+{
+    auto pair = SocketPair{};
+    auto buffer_size = 4096;
+    setsockopt(pair.fds[0], SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size));
+
+    auto sent = std::vector<std::byte>(1 << 20);
+    for (auto i = std::size_t{0}; i < sent.size(); i++)
+        sent[i] = static_cast<std::byte>(i * 31);
+
+    auto writer = std::jthread{[&]{
+        EXPECT_TRUE(send_all(pair.fds[0], sent));
+    }};
+
+    // Plain reads, each taking whatever has arrived.
+    auto received = std::vector<std::byte>{};
+    auto piece = std::array<std::byte, 1000>{};
+
+    while (received.size() < sent.size())
+    {
+        auto n = recv(pair.fds[1], piece.data(), piece.size(), 0);
+        ASSERT_GT(n, 0);
+        received.insert(received.end(), piece.begin(), piece.begin() + n);
+    }
+
+    EXPECT_EQ(received, sent);
+}
+
+TEST(SocketOpsTest, recv_all_waits_for_every_piece)
+{
+    auto pair = SocketPair{};
+    auto sent = limit(5);
+
+    auto writer = std::jthread{[&]{
+        auto bytes = std::as_bytes(std::span{&sent, 1});
+
+        for (auto offset = std::size_t{0}; offset < bytes.size(); offset += 8)
+        {
+            EXPECT_TRUE(send_all(pair.fds[0], bytes.subspan(offset, std::min<std::size_t>(8, bytes.size() - offset))));
+            std::this_thread::sleep_for(std::chrono::milliseconds{2});
+        }
+    }};
+
+    auto received = GenericMessage{};
+    ASSERT_TRUE(do_recv(pair.fds[1], received));
+    EXPECT_EQ(received.sequence, 5);
+    EXPECT_EQ(received.details.lim.price, sent.details.lim.price);
+}
+
+TEST(SocketOpsTest, recv_all_fails_if_the_peer_closes_first)
+{
+    auto pair = SocketPair{};
+    auto half = std::array<std::byte, sizeof(GenericMessage) / 2>{};
+
+    ASSERT_TRUE(send_all(pair.fds[0], half));
+    pair.close_end(0);
+
+    auto received = GenericMessage{};
+    auto ret = do_recv(pair.fds[1], received);
+    ASSERT_FALSE(ret);
+    EXPECT_EQ(ret.error(), SocketError::RecvFailed);
+}
+
+TEST(OutboxTest, keeps_room_for_replies_while_reports_wait)
+{
+    auto outbox = Outbox<int>{2, 2};
+    auto address = ReplyAddress<int>{&outbox, 0, 0};
+
+    address.notify(1);
+    address.notify(2);
+
+    auto third_queued = std::atomic<bool>{false};
+    auto reporter = std::jthread{[&]{
+        address.notify(3);
+        third_queued = true;
+    }};
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    EXPECT_FALSE(third_queued);
+
+    address.reply(10);
+    address.reply(11);
+
+    auto reply = Reply<int>{};
+    auto popped = std::vector<int>{};
+
+    while (popped.size() < 5)
+        if (outbox.try_pop(reply))
+            popped.push_back(reply.response);
+
+    reporter.join();
+    EXPECT_TRUE(third_queued);
+    EXPECT_EQ(popped.size(), 5);
+    EXPECT_EQ(std::ranges::count(popped, 3), 1);
+    EXPECT_EQ(std::vector(popped.begin(), popped.begin() + 4), (std::vector{1, 2, 10, 11}));
+}
+
+TEST(ShmRingTest, reports_full_and_empty)
+{
+    auto ring = ShmRing<int, 4>{};
+    auto value = 0;
+
+    EXPECT_TRUE(ring.empty());
+    EXPECT_FALSE(ring.try_pop(value));
+
+    for (auto i = 0; i < 4; i++)
+        EXPECT_TRUE(ring.try_push(i));
+
+    EXPECT_TRUE(ring.full());
+    EXPECT_FALSE(ring.try_push(4));
+
+    ASSERT_TRUE(ring.try_pop(value));
+    EXPECT_EQ(value, 0);
+    EXPECT_FALSE(ring.full());
+    EXPECT_TRUE(ring.try_push(4));
+}
+
+TEST(ShmRingTest, keeps_order_across_wraparound)
+{
+    auto ring = ShmRing<int, 4>{};
+    auto next_push = 0;
+    auto next_pop = 0;
+    auto value = 0;
+
+    // Three in, two out, so the indices run round the ring many times at
+    // every offset.
+    for (auto round = 0; round < 100; round++)
+    {
+        while (next_push - next_pop < 3)
+            ASSERT_TRUE(ring.try_push(next_push++));
+
+        for (auto i = 0; i < 2; i++)
+        {
+            ASSERT_TRUE(ring.try_pop(value));
+            EXPECT_EQ(value, next_pop++);
+        }
+    }
+
+    while (ring.try_pop(value))
+        EXPECT_EQ(value, next_pop++);
+
+    EXPECT_EQ(next_pop, next_push);
+}
+
+namespace
+{
+
+// Answers each request with its value plus one, for as long as the fixture
+// lives.
+class ShmTransportTest: public ::testing::Test
+{
+protected:
+    ShmTransportTest()
+    {
+        m_server.post_response_gen_callback([](int request){ return request + 1; });
+        m_loop = std::jthread{[this](std::stop_token stop){
+            m_server.start_server(stop);
+        }};
+    }
+
+    ShmServer<int> m_server;
+    std::jthread m_loop;
+};
+
+}
+
+TEST_F(ShmTransportTest, answers_requests_in_order)
+{
+    auto client = ShmClient<int>{};
+    auto requests = std::vector<int>{1, 2, 3};
+
+    ASSERT_TRUE(client.send_batch(requests));
+
+    for (auto request: requests)
+    {
+        auto response = client.recv_msg();
+        ASSERT_TRUE(response);
+        EXPECT_EQ(*response, request + 1);
+    }
+
+    auto response = client.send_msg_and_get_response(41);
+    ASSERT_TRUE(response);
+    EXPECT_EQ(*response, 42);
+}
+
+// A client that fills its response ring without reading must not hold up the
+// server for anyone else, and is served again once it reads.
+TEST_F(ShmTransportTest, slow_client_does_not_block_others)
+{
+    using RegionType = ShmRegion<int, int>;
+
+    auto slow = ShmClient<int>{};
+    auto requests = std::vector<int>(2 * RegionType::RING_CAPACITY);
+    std::iota(requests.begin(), requests.end(), 0);
+
+    ASSERT_TRUE(slow.send_batch(requests));
+
+    auto other = ShmClient<int>{};
+    auto response = other.send_msg_and_get_response(7);
+    ASSERT_TRUE(response);
+    EXPECT_EQ(*response, 8);
+
+    for (auto request: requests)
+    {
+        auto response = slow.recv_msg();
+        ASSERT_TRUE(response);
+        EXPECT_EQ(*response, request + 1);
+    }
+}
+
+// Clients leaving answers unread hand their slots back to be emptied, so
+// later clients reusing them only ever see their own.
+TEST_F(ShmTransportTest, reused_slots_start_empty)
+{
+    using RegionType = ShmRegion<int, int>;
+
+    for (auto i = 0; i < static_cast<int>(2 * RegionType::MAX_CLIENTS); i++)
+    {
+        auto client = ShmClient<int>{};
+
+        // Every slot may still be draining.
+        while (!client.connect())
+            std::this_thread::yield();
+
+        auto requests = std::vector<int>{i * 10, i * 10 + 1, i * 10 + 2};
+        ASSERT_TRUE(client.send_batch(requests));
+
+        auto response = client.recv_msg();
+        ASSERT_TRUE(response);
+        EXPECT_EQ(*response, i * 10 + 1);
+    }
+}
@@ -0,0 +1,82 @@
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <numeric>
+
+#include "gtest/gtest.h"
+
+#include "mpsc_queue.hpp"
+#include "work_stealing_pool.hpp"
+
+using namespace exchange;
+
+TEST(MPSCQueueTest, rejects_push_when_full)
+{
+    auto queue = MPSCQueue<int>{2};
+    auto value = 0;
+
+    EXPECT_TRUE(queue.try_push(1));
+    EXPECT_TRUE(queue.try_push(2));
+    EXPECT_FALSE(queue.try_push(3));
+
+    ASSERT_TRUE(queue.try_pop(value));
+    EXPECT_EQ(value, 1);
+    EXPECT_TRUE(queue.try_push(3));
+}
+
+TEST(MPSCQueueTest, delivers_every_item_from_many_producers)
+{
+    constexpr auto producers = 4;
+    constexpr auto per_producer = 10000;
+
+    auto queue = MPSCQueue<int>{64};
+    auto threads = std::vector<std::jthread>{};
+
+    for (auto p = 0; p < producers; p++)
+        threads.emplace_back([&]{
+            for (auto i = 1; i <= per_producer; i++)
+                while (!queue.try_push(i))
+                    std::this_thread::yield();
+        });
+
+    auto sum = 0l;
+    auto value = 0;
+
+    for (auto received = 0; received < producers * per_producer;)
+        if (queue.try_pop(value))
+        {
+            sum += value;
+            received++;
+        }
+
+    EXPECT_EQ(sum, producers * (per_producer * (per_producer + 1l) / 2));
+}
+
+TEST(WorkStealingPoolTest, runs_every_task_once)
+{
+    auto pool = WorkStealingPool{3};
+    auto counts = std::vector<std::atomic<int>>(1000);
+
+    pool.run(counts.size(), [&](std::size_t task){ counts[task]++; });
+
+    for (const auto& count: counts)
+        EXPECT_EQ(count.load(), 1);
+}
+
+TEST(WorkStealingPoolTest, rethrows_a_failed_task)
+{
+    auto pool = WorkStealingPool{2};
+    auto completed = std::atomic<int>{0};
+
+    EXPECT_THROW(pool.run(100, [&](std::size_t task){
+        if (task == 42)
+            throw std::runtime_error("task failed");
+        completed++;
+    }), std::runtime_error);
+
+    EXPECT_EQ(completed.load(), 99);
+
+    pool.run(10, [&](std::size_t){ completed++; });
+    EXPECT_EQ(completed.load(), 109);
+}
@@ -0,0 +1,384 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "book_registry.hpp"
+#include "exchange_state.hpp"
+#include "journal.hpp"
+
+using namespace exchange;
+using namespace order_protocol;
+
+namespace
+{
+
+auto journal_path(const std::string& name) -> std::string
+{
+    auto path = testing::TempDir() + name;
+    std::remove(path.c_str());
+    return path;
+}
+
+auto limit(InstrumentIDType instrument, PriceType price, SequenceType sequence) -> GenericMessage
+{
+    auto message = GenericMessage{};
+    message.message_type = MessageTypeID::LIMIT;
+    message.instrument_id = instrument;
+    message.sequence = sequence;
+    message.details.lim = {price, 10, Side::BUY};
+    return message;
+}
+
+}
+
+TEST(JournalTest, reads_back_what_was_appended)
+{
+    auto path = journal_path("journal_round_trip");
+
+    {
+        auto journal = Journal{{.path = path, .capacity = 16}};
+        EXPECT_TRUE(journal.append(limit(1, 40, 7), 123));
+        EXPECT_TRUE(journal.append(limit(2, 41, 8), NO_ORDER_ID));
+        EXPECT_EQ(journal.size(), 2u);
+    }
+
+    auto reader = JournalReader{path};
+    auto seen = std::vector<std::pair<GenericMessage, uint64_t>>{};
+
+    EXPECT_EQ(reader.for_each([&](uint64_t sequence, const GenericMessage& message, uint64_t order_id){
+        EXPECT_EQ(sequence, seen.size() + 1);
+        seen.emplace_back(message, order_id);
+    }), 2u);
+
+    ASSERT_EQ(seen.size(), 2u);
+    EXPECT_EQ(seen[0].first.instrument_id, 1u);
+    EXPECT_EQ(seen[0].first.sequence, 7u);
+    EXPECT_EQ(seen[0].first.details.lim.price, 40u);
+    EXPECT_EQ(seen[0].second, 123u);
+    EXPECT_EQ(seen[1].first.instrument_id, 2u);
+    EXPECT_EQ(seen[1].second, NO_ORDER_ID);
+}
+
+TEST(JournalTest, reopening_appends_after_existing_records)
+{
+    auto path = journal_path("journal_reopen");
+
+    {
+        auto journal = Journal{{.path = path, .capacity = 16}};
+        journal.append(limit(1, 40, 1), 1);
+    }
+
+    {
+        auto journal = Journal{{.path = path, .capacity = 16}};
+        EXPECT_EQ(journal.size(), 1u);
+        journal.append(limit(1, 41, 2), 2);
+    }
+
+    auto prices = std::vector<PriceType>{};
+    JournalReader{path}.for_each([&](uint64_t, const GenericMessage& message, uint64_t){
+        prices.push_back(message.details.lim.price);
+    });
+
+    EXPECT_EQ(prices, (std::vector<PriceType>{40, 41}));
+}
+
+TEST(JournalTest, drops_records_once_full)
+{
+    auto path = journal_path("journal_full");
+    auto journal = Journal{{.path = path, .capacity = 2}};
+
+    EXPECT_TRUE(journal.append(limit(1, 40, 1), 1));
+    EXPECT_TRUE(journal.append(limit(1, 40, 2), 2));
+    EXPECT_FALSE(journal.append(limit(1, 40, 3), 3));
+    EXPECT_EQ(journal.size(), 2u);
+    EXPECT_EQ(journal.dropped(), 1u);
+}
+
+TEST(JournalTest, keeps_each_threads_records_in_order)
+{
+    constexpr auto THREADS = 4;
+    constexpr auto PER_THREAD = 5000;
+
+    auto path = journal_path("journal_threads");
+
+    {
+        auto journal = Journal{{.path = path, .capacity = THREADS * PER_THREAD,
+                                .sync_interval = std::chrono::milliseconds{1}}};
+        auto threads = std::vector<std::jthread>{};
+
+        for (auto t = 0; t < THREADS; t++)
+            threads.emplace_back([&, t]{
+                for (auto i = 0; i < PER_THREAD; i++)
+                    journal.append(limit(t, 1, i), i);
+            });
+    }
+
+    auto next = std::vector<uint64_t>(THREADS);
+    auto read = JournalReader{path}.for_each([&](uint64_t, const GenericMessage& message, uint64_t order_id){
+        EXPECT_EQ(order_id, next[message.instrument_id]++);
+    });
+
+    EXPECT_EQ(read, static_cast<std::size_t>(THREADS * PER_THREAD));
+}
+
+TEST(JournalTest, rejects_files_that_are_not_journals)
+{
+    auto path = journal_path("journal_bad");
+
+    if (auto file = std::fopen(path.c_str(), "w"))
+    {
+        std::fputs("not a journal, though long enough to hold a header of one", file);
+        std::fclose(file);
+    }
+
+    EXPECT_THROW(JournalReader{path}, std::runtime_error);
+}
+
+TEST(ExchangeStateTest, snapshot_plus_tail_matches_full_replay)
+{
+    auto path = journal_path("journal_snapshot");
+    auto snapshot = journal_path("journal_snapshot.snap");
+
+    // Live books the journal is written from, with the ids they gave.
+    auto live = ExchangeState::BookMap{};
+    auto handler = BookMessageHandler<DiscardSink>{};
+
+    {
+        auto journal = Journal{{.path = path, .capacity = 64}};
+
+        auto journal_order = [&](const GenericMessage& message){
+            auto& book = ExchangeState::RegistryType::find_or_create_book(live, message.instrument_id);
+            auto response = handler(book, message, DiscardSink{});
+            journal.append(message, BookMessageHandler<DiscardSink>::resting_order_id(response));
+        };
+
+        for (auto i = 0u; i < 20; i++)
+        {
+            auto message = limit(i % 2, 30 + i % 5, i);
+            message.details.lim.side = i % 3 ? Side::BUY : Side::SELL;
+            journal_order(message);
+        }
+
+        journal.sync();
+
+        auto state = ExchangeState{};
+        EXPECT_EQ(state.replay(JournalReader{path}).applied, 20u);
+        ASSERT_TRUE(state.save(snapshot));
+
+        for (auto i = 20u; i < 30; i++)
+            journal_order(limit(i % 2, 20 + i, i));
+    }
+
+    auto full = ExchangeState{};
+    auto full_stats = full.replay(JournalReader{path});
+    EXPECT_EQ(full_stats.applied, 30u);
+    EXPECT_EQ(full_stats.mismatches, 0u);
+
+    auto restored = ExchangeState{};
+    ASSERT_TRUE(restored.load(snapshot));
+    EXPECT_EQ(restored.sequence(), 20u);
+
+    auto tail_stats = restored.replay(JournalReader{path});
+    EXPECT_EQ(tail_stats.applied, 10u);
+    EXPECT_EQ(tail_stats.mismatches, 0u);
+    EXPECT_EQ(restored.sequence(), 30u);
+
+    ASSERT_EQ(restored.books().size(), live.size());
+
+    for (auto& [instrument, book]: live)
+    {
+        auto& other = restored.books().at(instrument);
+        EXPECT_EQ(other.bid_depth(), book.bid_depth());
+        EXPECT_EQ(other.ask_depth(), book.ask_depth());
+        EXPECT_EQ(other.best_bid(), book.best_bid());
+        EXPECT_EQ(other.best_ask(), book.best_ask());
+    }
+
+    std::remove(snapshot.c_str());
+}
+
+TEST(ExchangeStateTest, rejects_files_that_are_not_snapshots)
+{
+    auto path = journal_path("not_a_snapshot");
+
+    if (auto file = std::fopen(path.c_str(), "w"))
+    {
+        std::fputs("not a snapshot", file);
+        std::fclose(file);
+    }
+
+    auto state = ExchangeState{};
+    EXPECT_FALSE(state.load(path));
+    EXPECT_FALSE(state.load(path + ".missing"));
+    EXPECT_EQ(state.sequence(), 0u);
+}
+
+TEST(AuctionTest, uncrosses_when_due_and_replays_from_the_journal)
+{
+    auto path = journal_path("journal_auction");
+    auto schedule = AuctionSchedule{{1, AuctionConfig{.order_count = 3}},
+                                    {2, AuctionConfig{.interval = std::chrono::milliseconds{1}}}};
+    auto books = BookMessageHandler<DiscardSink>::BookMap{};
+
+    {
+        auto journal = Journal{{.path = path, .capacity = 64}};
+        auto handler = BookMessageHandler<DiscardSink>{&journal, schedule};
+
+        auto submit = [&](const GenericMessage& message){
+            auto& book = ExchangeState::RegistryType::find_or_create_book(books, message.instrument_id);
+            auto response = handler(book, message, DiscardSink{});
+            handler.tick(books);
+            return response;
+        };
+
+        auto sell = limit(1, 99, 2);
+        sell.details.lim.side = Side::SELL;
+
+        // Rests although it crosses the first order, until the third arrives.
+        submit(limit(1, 100, 1));
+        EXPECT_FALSE(submit(sell).details.lresp.filled);
+        EXPECT_EQ(books.at(1).best_ask(), 99);
+        submit(limit(1, 101, 3));
+
+        EXPECT_EQ(books.at(1).best_ask(), std::nullopt);
+        EXPECT_EQ(books.at(1).bid_depth(), 10);
+
+        auto timed_sell = limit(2, 50, 4);
+        timed_sell.details.lim.side = Side::SELL;
+        submit(timed_sell);
+        submit(limit(2, 55, 5));
+        EXPECT_EQ(books.at(2).ask_depth(), 10);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds{5});
+        handler.tick(books);
+        EXPECT_EQ(books.at(2).ask_depth(), 0);
+        EXPECT_EQ(journal.size(), 7u);
+    }
+
+    auto auctions = std::vector<GenericMessage>{};
+    JournalReader{path}.for_each([&](uint64_t, const GenericMessage& message, uint64_t){
+        if (message.message_type == MessageTypeID::AUCTION)
+            auctions.push_back(message);
+    });
+
+    ASSERT_EQ(auctions.size(), 2u);
+    EXPECT_EQ(auctions[0].instrument_id, 1u);
+    EXPECT_EQ(auctions[1].instrument_id, 2u);
+
+    auto replayed = ExchangeState{schedule};
+    EXPECT_EQ(replayed.replay(JournalReader{path}).mismatches, 0u);
+    EXPECT_EQ(replayed.books().at(1).bid_depth(), books.at(1).bid_depth());
+    EXPECT_EQ(replayed.books().at(2).ask_depth(), 0);
+
+    // Without the schedule the orders match as they arrive instead.
+    auto continuous = ExchangeState{};
+    EXPECT_GT(continuous.replay(JournalReader{path}).mismatches, 0u);
+}
+
+#ifdef BOOK_PRICE_LADDER
+TEST(AuctionTest, rejected_orders_do_not_count_towards_an_auction)
+{
+    auto schedule = AuctionSchedule{{1, AuctionConfig{.order_count = 2}}};
+    auto handler = BookMessageHandler<DiscardSink>{nullptr, schedule};
+    auto books = BookMessageHandler<DiscardSink>::BookMap{};
+
+    auto submit = [&](const GenericMessage& message){
+        auto& book = ExchangeState::RegistryType::find_or_create_book(books, message.instrument_id);
+        auto response = handler(book, message, DiscardSink{});
+        handler.tick(books);
+        return response;
+    };
+
+    auto sell = limit(1, 99, 1);
+    sell.details.lim.side = Side::SELL;
+    submit(sell);
+
+    EXPECT_EQ(submit(limit(1, BOOK_LADDER_MAX_PRICE + 1, 2)).details.lresp.order_id, Book::REJECTED);
+    EXPECT_EQ(books.at(1).best_ask(), 99);
+
+    submit(limit(1, 100, 3));
+    EXPECT_EQ(books.at(1).best_ask(), std::nullopt);
+}
+#endif
+
+TEST(AuctionTest, retains_only_the_auctions_of_its_instruments)
+{
+    auto schedule = AuctionSchedule{{1, AuctionConfig{.interval = std::chrono::milliseconds{1}}},
+                                    {2, AuctionConfig{.interval = std::chrono::hours{1}}}};
+    auto handler = BookMessageHandler<DiscardSink>{nullptr, schedule};
+
+    EXPECT_LT(handler.next_deadline(), BookMessageHandler<DiscardSink>::Clock::now() + std::chrono::minutes{1});
+
+    handler.retain_instruments([](InstrumentIDType instrument){ return instrument == 2; });
+    EXPECT_GT(handler.next_deadline(), BookMessageHandler<DiscardSink>::Clock::now() + std::chrono::minutes{1});
+
+    handler.retain_instruments([](InstrumentIDType){ return false; });
+    EXPECT_EQ(handler.next_deadline(), BookMessageHandler<DiscardSink>::Clock::time_point::max());
+}
+
+namespace
+{
+
+using TestRegistry = BookRegistry<Book, BookMessageHandler<CompletionSink>>;
+
+auto submit_and_wait(TestRegistry& registry, const GenericMessage& message) -> GenericMessage
+{
+    auto completion = ShardCompletion{};
+    registry.submit(message, CompletionSink{&completion});
+    return completion.wait();
+}
+
+}
+
+TEST(BookRegistryTest, parked_shard_wakes_for_work_and_stop)
+{
+    auto registry = TestRegistry{1};
+
+    // Long enough for the idle shard to park.
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+
+    auto response = submit_and_wait(registry, limit(1, 100, 1));
+    EXPECT_EQ(response.message_type, MessageTypeID::LIM_RESP);
+    EXPECT_EQ(response.sequence, 1u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+}
+
+TEST(BookRegistryTest, parked_shard_runs_timed_auctions)
+{
+    auto schedule = AuctionSchedule{{2, AuctionConfig{.interval = std::chrono::milliseconds{20}}}};
+    auto registry = TestRegistry{1, 0, TestRegistry::DEFAULT_QUEUE_CAPACITY,
+                                 BookMessageHandler<CompletionSink>{nullptr, schedule}};
+
+    auto sell = limit(2, 50, 1);
+    sell.details.lim.side = Side::SELL;
+    auto resting = submit_and_wait(registry, sell).details.lresp.order_id;
+    submit_and_wait(registry, limit(2, 55, 2));
+
+    // Parked with nothing to wake it but the auction's deadline.
+    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+
+    auto cancel = GenericMessage{};
+    cancel.message_type = MessageTypeID::CANCEL;
+    cancel.instrument_id = 2;
+    cancel.details.can.order_id = resting;
+
+    EXPECT_FALSE(submit_and_wait(registry, cancel).details.cresp.cancelled);
+}
+
+TEST(BookRegistryTest, serves_instruments_within_the_order_id_prefix)
+{
+    auto books = TestRegistry::BookMap{};
+
+    EXPECT_TRUE(TestRegistry::serves(TestRegistry::MAX_INSTRUMENT_ID));
+    EXPECT_FALSE(TestRegistry::serves(TestRegistry::MAX_INSTRUMENT_ID + 1));
+
+    auto id = TestRegistry::find_or_create_book(books, TestRegistry::MAX_INSTRUMENT_ID).limit_buy(10, 100);
+    EXPECT_EQ(order_id_generator::prefix_of(id), TestRegistry::MAX_INSTRUMENT_ID);
+    EXPECT_THROW(TestRegistry::find_or_create_book(books, TestRegistry::MAX_INSTRUMENT_ID + 1), std::out_of_range);
+}
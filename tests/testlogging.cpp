@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "async_logger.hpp"
+
+using namespace exchange;
+
+namespace
+{
+
+enum class Colour { RED, GREEN };
+
+auto format(const LogRecord& record) -> std::string
+{
+    auto out = std::string{};
+    record.format(record.args.data(), out);
+    return out;
+}
+
+// Collects everything a logger writes. Only read once the logger is gone.
+struct CapturedOutput
+{
+    auto sink() -> AsyncLogger::Sink
+    {
+        return [this](std::string_view text){ this->text += text; };
+    }
+
+    std::string text;
+};
+
+}
+
+TEST(AsyncLoggerTest, record_formats_its_arguments)
+{
+    auto record = make_log_record<LogLevel::Warn, "Unable to read socket. Errno: {}">(11);
+
+    EXPECT_EQ(format(record), "[WARN] Unable to read socket. Errno: 11\n");
+}
+
+TEST(AsyncLoggerTest, record_keeps_mixed_arguments)
+{
+    auto record = make_log_record<LogLevel::Error, "{} {} {} {}">(uint16_t{7}, -3L, 2.5, Colour::GREEN);
+
+    EXPECT_EQ(format(record), "[ERROR] 7 -3 2.5 1\n");
+}
+
+TEST(AsyncLoggerTest, record_without_arguments)
+{
+    auto record = make_log_record<LogLevel::Info, "Placement failed.">();
+
+    EXPECT_EQ(format(record), "[INFO] Placement failed.\n");
+}
+
+TEST(AsyncLoggerTest, keeps_each_threads_records_in_order)
+{
+    constexpr auto THREADS = 4;
+    constexpr auto RECORDS = 1000;
+
+    auto output = CapturedOutput{};
+
+    {
+        auto logger = AsyncLogger{output.sink()};
+        auto threads = std::vector<std::jthread>{};
+
+        for (auto t = 0; t < THREADS; t++)
+            threads.emplace_back([&logger, t]{
+                for (auto i = 0; i < RECORDS; i++)
+                    logger.push(make_log_record<LogLevel::Info, "{} {}">(t, i));
+            });
+    }
+
+    auto next = std::vector<int>(THREADS, 0);
+    auto lines = std::istringstream{output.text};
+    auto level = std::string{};
+    auto t = 0;
+    auto i = 0;
+
+    while (lines >> level >> t >> i)
+    {
+        ASSERT_EQ(level, "[INFO]");
+        ASSERT_EQ(i, next[t]++);
+    }
+
+    EXPECT_TRUE(lines.eof());
+    EXPECT_EQ(next, std::vector<int>(THREADS, RECORDS));
+}
+
+TEST(AsyncLoggerTest, counts_records_dropped_on_a_full_ring)
+{
+    constexpr auto CAPACITY = std::size_t{64};
+    constexpr auto EXTRA = std::size_t{10};
+
+    auto output = CapturedOutput{};
+    auto writing = std::atomic<bool>{false};
+    auto release = std::atomic<bool>{false};
+
+    {
+        // Hold the logger's thread inside the sink so nothing is drained.
+        auto logger = AsyncLogger{[&](std::string_view text){
+            output.text += text;
+            writing = true;
+            while (!release)
+                std::this_thread::yield();
+        }, CAPACITY};
+
+        logger.push(make_log_record<LogLevel::Info, "first">());
+
+        while (!writing)
+            std::this_thread::yield();
+
+        for (auto i = std::size_t{0}; i < CAPACITY + EXTRA; i++)
+            logger.push(make_log_record<LogLevel::Info, "{}">(i));
+
+        EXPECT_EQ(logger.dropped(), EXTRA);
+        release = true;
+    }
+
+    EXPECT_NE(output.text.find("[INFO] 63\n"), std::string::npos);
+    EXPECT_EQ(output.text.find("[INFO] 64\n"), std::string::npos);
+    EXPECT_NE(output.text.find("[WARN] 10 log records dropped\n"), std::string::npos);
+}
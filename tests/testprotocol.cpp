@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <span>
+
+#include "book_order_proto.hpp"
+#include "wire_format.hpp"
+
+using namespace order_protocol;
+
+namespace
+{
+
+auto encode(const GenericMessage& message, std::array<std::byte, wire::MAX_FRAME_SIZE>& buffer) -> std::span<std::byte>
+{
+    auto size = wire_codec::encode<GenericMessage>(message, buffer.data());
+    return std::span{buffer}.first(size);
+}
+
+}
+
+TEST(WireFormatTest, limit_round_trip)
+{
+    auto message = GenericMessage{};
+    message.message_type = MessageTypeID::LIMIT;
+    message.instrument_id = 7;
+    message.sequence = 42;
+    message.details.lim = {.price = 101, .volume = 30, .side = Side::SELL};
+
+    auto buffer = std::array<std::byte, wire::MAX_FRAME_SIZE>{};
+    auto frame = encode(message, buffer);
+
+    EXPECT_LT(frame.size(), sizeof(GenericMessage));
+    ASSERT_EQ(wire_codec::frame_size<GenericMessage>(frame), frame.size());
+
+    auto decoded = GenericMessage{};
+    ASSERT_TRUE(wire_codec::decode<GenericMessage>(frame, decoded));
+    EXPECT_EQ(decoded.message_type, MessageTypeID::LIMIT);
+    EXPECT_EQ(decoded.instrument_id, 7);
+    EXPECT_EQ(decoded.sequence, 42);
+    EXPECT_EQ(decoded.details.lim.price, 101);
+    EXPECT_EQ(decoded.details.lim.volume, 30);
+    EXPECT_EQ(decoded.details.lim.side, Side::SELL);
+}
+
+TEST(WireFormatTest, limit_response_round_trip)
+{
+    auto message = GenericMessage{};
+    message.message_type = MessageTypeID::LIM_RESP;
+    message.sequence = 3;
+    message.details.lresp = {.filled = false, .order_id = 0xABCD'0000'0001};
+
+    auto buffer = std::array<std::byte, wire::MAX_FRAME_SIZE>{};
+    auto frame = encode(message, buffer);
+
+    auto decoded = GenericMessage{};
+    ASSERT_TRUE(wire_codec::decode<GenericMessage>(frame, decoded));
+    EXPECT_FALSE(decoded.details.lresp.filled);
+    EXPECT_EQ(decoded.details.lresp.order_id, 0xABCD'0000'0001);
+}
+
+TEST(WireFormatTest, execution_report_round_trip)
+{
+    auto message = GenericMessage{};
+    message.message_type = MessageTypeID::EXEC_REPORT;
+    message.instrument_id = 2;
+    message.details.exec = {.order_id = 0x0002'0000'0005, .volume = 4, .price = 37, .remaining = 6};
+
+    auto buffer = std::array<std::byte, wire::MAX_FRAME_SIZE>{};
+    auto frame = encode(message, buffer);
+
+    auto decoded = GenericMessage{};
+    ASSERT_TRUE(wire_codec::decode<GenericMessage>(frame, decoded));
+    EXPECT_EQ(decoded.message_type, MessageTypeID::EXEC_REPORT);
+    EXPECT_EQ(decoded.details.exec.order_id, 0x0002'0000'0005);
+    EXPECT_EQ(decoded.details.exec.volume, 4);
+    EXPECT_EQ(decoded.details.exec.price, 37);
+    EXPECT_EQ(decoded.details.exec.remaining, 6);
+}
+
+TEST(WireFormatTest, auction_round_trip)
+{
+    auto message = GenericMessage{};
+    message.message_type = MessageTypeID::AUCTION;
+    message.instrument_id = 3;
+    message.details.auction = {.price = 98, .volume = 0x1'0000'0002};
+
+    auto buffer = std::array<std::byte, wire::MAX_FRAME_SIZE>{};
+    auto frame = encode(message, buffer);
+
+    auto decoded = GenericMessage{};
+    ASSERT_TRUE(wire_codec::decode<GenericMessage>(frame, decoded));
+    EXPECT_EQ(decoded.message_type, MessageTypeID::AUCTION);
+    EXPECT_EQ(decoded.details.auction.price, 98);
+    EXPECT_EQ(decoded.details.auction.volume, 0x1'0000'0002);
+}
+
+TEST(WireFormatTest, rejection_round_trip)
+{
+    auto request = GenericMessage{};
+    request.message_type = MessageTypeID::AUCTION;
+    request.instrument_id = 3;
+    request.sequence = 12;
+
+    auto buffer = std::array<std::byte, wire::MAX_FRAME_SIZE>{};
+    auto frame = encode(rejection(request), buffer);
+
+    auto decoded = GenericMessage{};
+    ASSERT_TRUE(wire_codec::decode<GenericMessage>(frame, decoded));
+    EXPECT_EQ(decoded.message_type, MessageTypeID::REJECT);
+    EXPECT_EQ(decoded.instrument_id, 3);
+    EXPECT_EQ(decoded.sequence, 12);
+    EXPECT_EQ(decoded.details.reject.type, MessageTypeID::AUCTION);
+}
+
+TEST(ClientRequestTest, only_orders_and_cancels_are_taken_from_clients)
+{
+    for (auto i = std::size_t{0}; i < MESSAGE_TYPE_COUNT; i++)
+    {
+        auto type = static_cast<MessageTypeID>(i);
+        auto expected = type == MessageTypeID::LIMIT || type == MessageTypeID::FOK || type == MessageTypeID::CANCEL;
+
+        EXPECT_EQ(is_client_request(type), expected) << i;
+    }
+}
+
+TEST(WireFormatTest, partial_frame_needs_more_bytes)
+{
+    auto message = GenericMessage{};
+    message.message_type = MessageTypeID::CANCEL;
+    message.details.can.order_id = 9;
+
+    auto buffer = std::array<std::byte, wire::MAX_FRAME_SIZE>{};
+    auto frame = encode(message, buffer);
+
+    EXPECT_EQ(wire_codec::frame_size<GenericMessage>(frame.first(frame.size() - 1)), 0);
+    EXPECT_EQ(wire_codec::frame_size<GenericMessage>(frame.first(3)), 0);
+}
+
+TEST(WireFormatTest, rejects_malformed_frames)
+{
+    auto message = GenericMessage{};
+    message.message_type = MessageTypeID::FOK;
+
+    auto buffer = std::array<std::byte, wire::MAX_FRAME_SIZE>{};
+    auto frame = encode(message, buffer);
+    auto decoded = GenericMessage{};
+
+    frame[0] = std::byte{wire::VERSION + 1};
+    EXPECT_FALSE(wire_codec::decode<GenericMessage>(frame, decoded));
+
+    frame[0] = std::byte{wire::VERSION};
+    frame[1] = std::byte{0xFF};
+    EXPECT_FALSE(wire_codec::decode<GenericMessage>(frame, decoded));
+
+    frame[1] = std::byte{static_cast<uint8_t>(MessageTypeID::FOK)};
+    EXPECT_FALSE(wire_codec::decode<GenericMessage>(frame.first(wire::HEADER_SIZE), decoded));
+}
+
+TEST(VisitMessageTest, passes_the_details_of_the_message_type)
+{
+    auto message = GenericMessage{};
+    message.message_type = MessageTypeID::CANCEL;
+    message.details.can.order_id = 17;
+
+    auto seen = OrderIDType{};
+    auto known = visit_message(message, [&](auto type, const auto& details){
+        if constexpr (decltype(type)::value == MessageTypeID::CANCEL)
+            seen = details.order_id;
+        else
+            FAIL();
+    });
+
+    EXPECT_TRUE(known);
+    EXPECT_EQ(seen, 17);
+
+    message.message_type = static_cast<MessageTypeID>(MESSAGE_TYPE_COUNT);
+    EXPECT_FALSE(visit_message(message, [](auto, const auto&){ FAIL(); }));
+}
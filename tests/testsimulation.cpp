@@ -0,0 +1,351 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <fstream>
+#include <queue>
+#include <random>
+
+#include "book_simulation.hpp"
+#include "columnar_file.hpp"
+#include "event_queue.hpp"
+#include "event_simulation.hpp"
+#include "lane_rng.hpp"
+#include "parameter_sweep.hpp"
+#include "population_simulation.hpp"
+
+using namespace exchange;
+
+namespace
+{
+
+auto small_config(uint64_t seed) -> SimulationConfig
+{
+    auto config = SimulationConfig{};
+    config.agents = 4;
+    config.steps = 20'000;
+    config.seed = seed;
+    return config;
+}
+
+}
+
+TEST(BookSimulationTest, runs_the_configured_steps)
+{
+    auto simulation = BookSimulation<>{small_config(1)};
+    const auto& report = simulation.run();
+
+    EXPECT_EQ(report.steps, 20'000);
+    EXPECT_GT(report.orders_placed, 0);
+    EXPECT_GT(report.fills.fills, 0);
+    EXPECT_EQ(report.fills.volume, report.fills.fills * 10);
+    EXPECT_LE(report.cancels_succeeded, report.cancels_attempted);
+}
+
+TEST(BookSimulationTest, same_seed_replays_the_same_run)
+{
+    auto first = BookSimulation<>{small_config(7)};
+    auto second = BookSimulation<>{small_config(7)};
+    const auto& a = first.run();
+    const auto& b = second.run();
+
+    EXPECT_EQ(a.orders_placed, b.orders_placed);
+    EXPECT_EQ(a.filled_immediately, b.filled_immediately);
+    EXPECT_EQ(a.cancels_succeeded, b.cancels_succeeded);
+    EXPECT_EQ(a.fills.fills, b.fills.fills);
+    EXPECT_EQ(a.fills.notional, b.fills.notional);
+}
+
+TEST(BookSimulationTest, agents_only_cancel_orders_still_resting)
+{
+    auto simulation = BookSimulation<>{small_config(3)};
+    const auto& report = simulation.run();
+
+    // Fills are passed back to their agents, so no cancel is wasted on an
+    // order that has already traded.
+    EXPECT_GT(report.fills.fills, 0u);
+    EXPECT_GT(report.cancels_attempted, 0u);
+    EXPECT_EQ(report.cancels_succeeded, report.cancels_attempted);
+}
+
+TEST(PatientAgentTest, forgets_orders_once_filled)
+{
+    auto agent = PatientAgent{1.0, 0.0, 10, 5};
+    auto next_id = PatientAgent::OrderIDType{0};
+
+    agent.post_place_callback([&](auto, auto, auto)
+        -> std::expected<PatientAgent::OrderIDType, PatientAgent::PlaceOutcome> {
+        return {next_id++};
+    });
+
+    for (auto i = 0; i < 4; i++)
+        ASSERT_TRUE(agent.perform(PatientAgent::Action::PLACE));
+
+    agent.on_execution(1, 3);
+    EXPECT_EQ(agent.active_orders().size(), 4u);
+
+    agent.on_execution(1, 0);
+    agent.on_execution(0, 0);
+    agent.on_execution(0, 0);
+
+    auto remaining = std::vector(agent.active_orders().begin(), agent.active_orders().end());
+    std::ranges::sort(remaining);
+    EXPECT_EQ(remaining, (std::vector<PatientAgent::OrderIDType>{2, 3}));
+}
+
+TEST(BookSimulationTest, different_seeds_diverge)
+{
+    auto first = BookSimulation<>{small_config(1)};
+    auto second = BookSimulation<>{small_config(2)};
+
+    EXPECT_NE(first.run().fills.notional, second.run().fills.notional);
+}
+
+TEST(RadixEventQueueTest, pops_in_time_order)
+{
+    auto queue = RadixEventQueue<int>{};
+    auto reference = std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<>>{};
+    auto eng = std::mt19937_64{3};
+    auto delay = std::uniform_int_distribution<uint64_t>{0, 1'000'000};
+    auto now = uint64_t{0};
+
+    for (auto i = 0; i < 1000; i++)
+    {
+        auto time = now + delay(eng);
+        queue.push(time, i);
+        reference.push(time);
+    }
+
+    // Interleave pops with pushes no earlier than the last pop.
+    for (auto i = 0; i < 5000; i++)
+    {
+        auto [time, value] = queue.pop();
+        ASSERT_EQ(time, reference.top());
+        reference.pop();
+        now = time;
+
+        auto next = now + delay(eng);
+        queue.push(next, i);
+        reference.push(next);
+    }
+
+    while (!queue.empty())
+    {
+        ASSERT_EQ(queue.pop().first, reference.top());
+        reference.pop();
+    }
+}
+
+TEST(RadixEventQueueTest, keeps_events_due_at_the_same_time)
+{
+    auto queue = RadixEventQueue<int>{};
+    queue.push(5, 1);
+    queue.push(5, 2);
+    queue.push(9, 3);
+
+    auto first = queue.pop();
+    auto second = queue.pop();
+
+    EXPECT_EQ(first.first, 5);
+    EXPECT_EQ(second.first, 5);
+    EXPECT_EQ(first.second + second.second, 3);
+    EXPECT_EQ(queue.pop(), std::make_pair(uint64_t{9}, 3));
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(EventSimulationTest, runs_until_the_duration)
+{
+    auto config = EventSimulationConfig{};
+    config.agents = 1000;
+    config.duration = std::chrono::seconds{5};
+
+    auto simulation = EventSimulation<>{config};
+    const auto& report = simulation.run();
+
+    // 1000 agents acting 0.8 times a second for 5 seconds.
+    EXPECT_GT(report.events, 3500);
+    EXPECT_LT(report.events, 4500);
+    EXPECT_LE(report.simulated, config.duration);
+    EXPECT_LE(report.orders_placed + report.cancels_attempted, report.events);
+    EXPECT_GT(report.fills.fills, 0);
+}
+
+TEST(EventSimulationTest, same_seed_replays_the_same_run)
+{
+    auto config = EventSimulationConfig{};
+    config.agents = 500;
+    config.duration = std::chrono::seconds{5};
+
+    auto first = EventSimulation<>{config};
+    auto second = EventSimulation<>{config};
+    const auto& a = first.run();
+    const auto& b = second.run();
+
+    EXPECT_EQ(a.events, b.events);
+    EXPECT_EQ(a.fills.fills, b.fills.fills);
+    EXPECT_EQ(a.fills.notional, b.fills.notional);
+}
+
+TEST(EventSimulationTest, runs_in_stages_like_one_run)
+{
+    auto config = EventSimulationConfig{};
+    config.agents = 500;
+    config.duration = std::chrono::seconds{4};
+
+    auto whole = EventSimulation<>{config};
+    auto staged = EventSimulation<>{config};
+    const auto& a = whole.run();
+
+    staged.run(std::chrono::seconds{1});
+    staged.run(std::chrono::seconds{1});
+    staged.run(std::chrono::seconds{3});
+    const auto& b = staged.run();
+
+    EXPECT_EQ(a.events, b.events);
+    EXPECT_EQ(a.orders_placed, b.orders_placed);
+    EXPECT_EQ(a.cancels_attempted, b.cancels_attempted);
+    EXPECT_EQ(a.fills.fills, b.fills.fills);
+    EXPECT_EQ(a.fills.notional, b.fills.notional);
+}
+
+TEST(ColumnarTableTest, round_trips_through_a_file)
+{
+    auto table = ColumnarTable{};
+    table.u64_column("size") = {1, 2, 3};
+    table.f64_column("rate") = {0.5, 0.25, 0.125};
+
+    auto path = testing::TempDir() + "columnar_test.mmcol";
+    ASSERT_TRUE(table.write(path));
+
+    auto read = ColumnarTable::read(path);
+    ASSERT_TRUE(read);
+    EXPECT_EQ(read->rows(), 3u);
+    EXPECT_EQ(read->columns(), 2u);
+    EXPECT_EQ(std::get<std::vector<uint64_t>>(*read->find("size")), table.u64_column("size"));
+    EXPECT_EQ(std::get<std::vector<double>>(*read->find("rate")), table.f64_column("rate"));
+    EXPECT_EQ(read->find("missing"), nullptr);
+}
+
+TEST(ColumnarTableTest, rejects_corrupt_files)
+{
+    auto write_file = [](const std::string& name, uint64_t rows, uint8_t type){
+        auto path = testing::TempDir() + name;
+        auto out = std::ofstream{path, std::ios::binary | std::ios::trunc};
+        auto columns = uint64_t{1};
+        auto name_length = uint16_t{1};
+        auto value = uint64_t{7};
+
+        out.write(ColumnarTable::MAGIC.data(), ColumnarTable::MAGIC.size());
+        out.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+        out.write(reinterpret_cast<const char*>(&columns), sizeof(columns));
+        out.write(reinterpret_cast<const char*>(&name_length), sizeof(name_length));
+        out.write("x", 1);
+        out.write(reinterpret_cast<const char*>(&type), sizeof(type));
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+
+        return path;
+    };
+
+    // Claims far more rows than the file holds.
+    EXPECT_FALSE(ColumnarTable::read(write_file("columnar_rows.mmcol", ~uint64_t{0}, 0)));
+    EXPECT_FALSE(ColumnarTable::read(write_file("columnar_type.mmcol", 1, 2)));
+    EXPECT_TRUE(ColumnarTable::read(write_file("columnar_valid.mmcol", 1, 0)));
+}
+
+TEST(ParameterSweepTest, results_do_not_depend_on_the_thread_count)
+{
+    auto grid = SweepGrid{};
+    grid.placement_rates = {0.3, 0.5};
+    grid.cancellation_rates = {0.4};
+    grid.order_sizes = {5, 10};
+    grid.replications = 3;
+    grid.agents = 4;
+    grid.steps = 2'000;
+
+    auto single = WorkStealingPool{1};
+    auto several = WorkStealingPool{3};
+    auto first = ParameterSweep<>{grid}.run(single);
+    auto second = ParameterSweep<>{grid}.run(several);
+
+    ASSERT_EQ(first.rows(), 4u);
+    EXPECT_EQ(std::get<std::vector<double>>(*first.find("fill_rate_mean")),
+              std::get<std::vector<double>>(*second.find("fill_rate_mean")));
+    EXPECT_EQ(std::get<std::vector<double>>(*first.find("volatility_mean")),
+              std::get<std::vector<double>>(*second.find("volatility_mean")));
+
+    for (auto fill_rate: std::get<std::vector<double>>(*first.find("fill_rate_mean")))
+    {
+        EXPECT_GT(fill_rate, 0);
+        EXPECT_LE(fill_rate, 1);
+    }
+}
+
+TEST(Xoshiro256LanesTest, batch_draws_follow_each_lanes_stream)
+{
+    auto batched = Xoshiro256Lanes{37, 9};
+    auto single = Xoshiro256Lanes{37, 9};
+    auto uniforms = std::vector<double>(37);
+
+    for (auto round = 0; round < 3; round++)
+    {
+        batched.uniform(uniforms);
+
+        for (auto lane = std::size_t{0}; lane < uniforms.size(); lane++)
+        {
+            EXPECT_EQ(uniforms[lane], single.uniform(lane));
+            EXPECT_GE(uniforms[lane], 0.0);
+            EXPECT_LT(uniforms[lane], 1.0);
+        }
+    }
+
+    EXPECT_NE(single.next(0), single.next(1));
+}
+
+TEST(PoissonTableTest, samples_have_the_rate_as_mean)
+{
+    auto rng = Xoshiro256Lanes{1024, 3};
+    auto table = PoissonTable{0.4};
+    auto uniforms = std::vector<double>(rng.lanes());
+    auto counts = std::vector<uint8_t>(rng.lanes());
+    auto total = 0.0;
+    auto draws = 0.0;
+
+    for (auto round = 0; round < 200; round++)
+    {
+        rng.uniform(uniforms);
+        table.sample<uint8_t>(uniforms, counts);
+
+        for (auto count: counts)
+            total += count;
+
+        draws += counts.size();
+    }
+
+    EXPECT_NEAR(total / draws, 0.4, 0.01);
+    EXPECT_EQ(table.sample(0.0), 0u);
+}
+
+TEST(PopulationSimulationTest, replays_and_only_cancels_resting_orders)
+{
+    auto config = small_config(11);
+    config.agents = 500;
+    config.steps = 200;
+
+    auto first = PopulationSimulation<>{config};
+    auto second = PopulationSimulation<>{config};
+    const auto& a = first.run();
+    const auto& b = second.run();
+
+    EXPECT_EQ(a.steps, 200u);
+    EXPECT_GT(a.fills.fills, 0u);
+    EXPECT_EQ(a.orders_placed, b.orders_placed);
+    EXPECT_EQ(a.fills.notional, b.fills.notional);
+    EXPECT_GT(a.cancels_attempted, 0u);
+    EXPECT_EQ(a.cancels_succeeded, a.cancels_attempted);
+
+    auto resting = std::size_t{0};
+
+    for (auto agent = std::size_t{0}; agent < config.agents; agent++)
+        resting += first.active_orders(agent).size();
+
+    EXPECT_EQ(resting * config.order_size, first.book().bid_depth() + first.book().ask_depth());
+}